@@ -2,15 +2,23 @@
 
 let g:eovim_running = 1
 
+" g:eovim_channel is set by eovim before this file is sourced
 function! Eovim(request, ...)
-   let l:file = '/dev/stdout'
    if (a:0 == 0)
-      call writefile(msgpackdump([[2, 'eovim', [[a:request]]]]), l:file, 'ab')
+      call rpcnotify(g:eovim_channel, 'eovim', [a:request])
    else
-      call writefile(msgpackdump([[2, 'eovim', [[a:request, a:000]]]]), l:file, 'ab')
+      call rpcnotify(g:eovim_channel, 'eovim', [a:request, a:000])
    endif
 endfunction
 
+" Open a new eovim window, with its own neovim, from the current directory
+command! -nargs=* -complete=file EovimNewWindow
+   \ call Eovim('new_window', getcwd(), [<f-args>])
+
+" Show the last inputs eovim received, and how long each stage took
+command! EovimJournal
+   \ echo join(rpcrequest(g:eovim_channel, 'journal'), "\n")
+
 let g:eovim_theme_bell_enabled = 0
 let g:eovim_theme_react_to_key_presses = 1
 let g:eovim_theme_react_to_caps_lock = 1
@@ -20,6 +28,11 @@ let g:eovim_cursor_animated = 1
 let g:eovim_cursor_animation_duration = 0.05
 let g:eovim_cursor_animation_style = 'accelerate'
 
+let g:eovim_perf_hud = 0
+
+let g:eovim_key_repeat_throttle = 0
+let g:eovim_predictive_echo = 0
+
 
 let g:eovim_theme_completion_styles = {
 	\ 'default': 'font_weight=bold color=#ffffff',
@@ -50,7 +63,32 @@ let g:eovim_ext_cmdline = 1
 let g:eovim_ext_multigrid = 0
 
 augroup Eovim
+   " Eovim waits for this request before it reads its configuration
+   autocmd VimEnter * call rpcrequest(g:eovim_channel, 'vimenter')
    autocmd User EovimReady :
    autocmd User EovimCapsLockOn :
    autocmd User EovimCapsLockOff :
 augroup END
+
+" Eovim is the clipboard provider: the "+" and "*" registers are the selections
+" of eovim's window. A g:clipboard set in init.vim replaces this one.
+let g:clipboard = {
+   \ 'name': 'eovim',
+   \ 'copy': {
+   \    '+': {lines, regtype -> Eovim('clipboard_set', '+', lines, regtype)},
+   \    '*': {lines, regtype -> Eovim('clipboard_set', '*', lines, regtype)},
+   \ },
+   \ 'paste': {
+   \    '+': {-> rpcrequest(g:eovim_channel, 'clipboard_get', '+')},
+   \    '*': {-> rpcrequest(g:eovim_channel, 'clipboard_get', '*')},
+   \ },
+   \}
+
+" Notify eovim each time one of its settings is set, so it is applied right
+" away. Settings that are removed keep their last value.
+function! s:eovim_config_changed(dict, key, change) abort
+   if has_key(a:change, 'new')
+      call rpcnotify(g:eovim_channel, 'eovim', ['config', a:key, a:change.new])
+   endif
+endfunction
+call dictwatcheradd(g:, 'eovim_*', function('s:eovim_config_changed'))
@@ -0,0 +1,46 @@
+/* This file is part of Eovim, which is under the MIT License ****************/
+
+#ifndef __EOVIM_BENCH_H__
+#define __EOVIM_BENCH_H__
+
+#include <Eina.h>
+
+/**
+ * Milestones of eovim's startup, in the order they are expected to be reached.
+ * See nvim_attach() for the description of the attach callback chain.
+ */
+enum bench_stage {
+	BENCH_STAGE_PROCESS = 0, /**< The process was loaded */
+	BENCH_STAGE_MAIN, /**< Entered elm_main(): the EFL are initialized */
+	BENCH_STAGE_MODULES, /**< All eovim modules are initialized */
+	BENCH_STAGE_THEME, /**< The Edje theme was loaded in the main layout */
+	BENCH_STAGE_GUI, /**< The nvim process is spawned and the GUI is created */
+	BENCH_STAGE_API_INFO, /**< nvim's API information were received */
+	BENCH_STAGE_ATTACH_ACK, /**< nvim acknowledged the UI attachment */
+	BENCH_STAGE_UI_ATTACHED, /**< The UI is attached: init.vim was sourced */
+	BENCH_STAGE_CONFIG, /**< The configuration variables were requested */
+	BENCH_STAGE_FIRST_FLUSH, /**< First call to termview_flush() */
+	BENCH_STAGE_FIRST_FRAME, /**< First frame rendered after the first flush */
+	__BENCH_STAGE_LAST /* Sentinel */
+};
+
+/**
+ * Register the time at which the stage @p stage was reached. Only the first
+ * call for a given stage is taken into account.
+ *
+ * @param[in] stage The startup milestone that was just reached
+ */
+void bench_mark(enum bench_stage stage);
+
+/**
+ * @return EINA_TRUE if the stage @p stage was already reached, EINA_FALSE
+ * otherwise.
+ */
+Eina_Bool bench_reached(enum bench_stage stage);
+
+/**
+ * Print the time spent in each startup stage on the standard output
+ */
+void bench_report(void);
+
+#endif /* ! __EOVIM_BENCH_H__ */
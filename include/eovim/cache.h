@@ -0,0 +1,36 @@
+/* This file is part of Eovim, which is under the MIT License ****************/
+
+#ifndef __EOVIM_CACHE_H__
+#define __EOVIM_CACHE_H__
+
+#include "eovim/types.h"
+
+/**
+ * @file cache.h
+ *
+ * Eovim keeps data that is costly to compute, but can be recomputed at any
+ * time, in the user's cache directory: $XDG_CACHE_HOME/eovim (~/.cache/eovim
+ * by default). Files in there can be removed at any time.
+ */
+
+/**
+ * Forge the path of @p name in the user's cache directory ($XDG_CACHE_HOME,
+ * or ~/.cache). The files of eovim are in its "eovim" sub-directory.
+ *
+ * @param[out] path Buffer that receives the path
+ * @param[in] size Size of @p path, in bytes
+ * @param[in] name Path of the file, relative to the user's cache directory
+ * @return EINA_TRUE on success, EINA_FALSE if @p path is too small
+ */
+Eina_Bool cache_path_get(char *path, size_t size, const char *name);
+
+/**
+ * Replace the file at @p path by the contents of @p sbuf. Missing directories
+ * are created. The file is written aside then moved in place, so readers
+ * never see a partially written file. Only the user can read and write it.
+ *
+ * @return EINA_TRUE on success, EINA_FALSE otherwise
+ */
+Eina_Bool cache_write(const char *path, const msgpack_sbuffer *sbuf);
+
+#endif /* ! __EOVIM_CACHE_H__ */
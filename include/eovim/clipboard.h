@@ -0,0 +1,53 @@
+/* This file is part of Eovim, which is under the MIT License ****************/
+
+#ifndef __EOVIM_CLIPBOARD_H__
+#define __EOVIM_CLIPBOARD_H__
+
+#include "eovim/types.h"
+
+/**
+ * @file clipboard.h
+ *
+ * Eovim is the clipboard provider of neovim (see :help clipboard): our runtime
+ * sets g:clipboard, so the "+" and "*" registers are read and written by eovim
+ * through the selections of the windowing system, instead of by spawning
+ * xclip, xsel or wl-copy for each yank and paste.
+ *
+ * - Yanks are sent with the "clipboard_set" notification, so neovim does not
+ *   wait for the selection to be set:
+ *
+ *     ["clipboard_set", [register, lines, regtype]]
+ *
+ * - Pastes are requested with the "clipboard_get" request, whose result is
+ *   [lines, regtype]. While eovim still owns the selection it set last, the
+ *   text neovim yanked is given back as is (with its exact regtype), without
+ *   reading the selection again.
+ *
+ * Yanks are not streamed: neovim's provider gives all the lines of a register
+ * in a single call, and expects all of them back from a single one. Large
+ * texts are only streamed the other way, when pasted (see paste.h).
+ */
+
+Eina_Bool clipboard_init(void);
+void clipboard_shutdown(void);
+
+/**
+ * Set the selection of the register "+" (clipboard) or "*" (primary).
+ *
+ * @param[in] nvim The neovim handle
+ * @param[in] params The parameters of the "clipboard_set" notification
+ * @return EINA_TRUE on success, EINA_FALSE on failure
+ */
+Eina_Bool clipboard_set(struct nvim *nvim, const msgpack_object_array *params);
+
+/**
+ * Release the selections kept for @p nvim, and answer a pending read with an
+ * empty selection. Elementary does not call back @p nvim anymore: the loss
+ * callbacks are unregistered, and a read that is still pending is detached.
+ * This is called when the window is deleted, and again when @p nvim is freed.
+ *
+ * @param[in] nvim The neovim handle
+ */
+void clipboard_release(struct nvim *nvim);
+
+#endif /* ! __EOVIM_CLIPBOARD_H__ */
@@ -0,0 +1,48 @@
+/* This file is part of Eovim, which is under the MIT License ****************/
+
+#ifndef __EOVIM_DAEMON_H__
+#define __EOVIM_DAEMON_H__
+
+#include "eovim/types.h"
+
+/**
+ * @file daemon.h
+ *
+ * The daemon (eovim --daemon) is a resident eovim process. It keeps the EFL,
+ * the theme and a few neovim instances warm: they are spawned and attached
+ * ahead of time, behind hidden windows.
+ *
+ * A client (eovim --client) asks the daemon, over a local socket, to open
+ * files. The daemon then shows the window of a warm instance, makes neovim
+ * edit the files from the client's working directory, and spawns another
+ * instance to replace it. Both talk msgpack-rpc, with the "open" request:
+ *
+ *   [0, req_id, "open", [cwd, [file...]]]
+ */
+
+/**
+ * Start serving the clients and spawn the warm neovim instances. The main loop
+ * must then be run.
+ *
+ * @param[in] opts The options of all the neovim instances
+ * @param[in] args Arguments forwarded to all the neovim instances
+ * @return EINA_TRUE on success, EINA_FALSE on failure
+ */
+Eina_Bool daemon_start(const struct options *opts, const char *const args[]);
+
+/**
+ * Stop serving the clients, and release all the neovim instances.
+ */
+void daemon_stop(void);
+
+/**
+ * Ask the daemon to open @p files. This runs the main loop until the daemon
+ * replied, so it must be called before the main loop is started.
+ *
+ * @param[in] files NULL-terminated list of files to be opened
+ * @return EINA_TRUE if the daemon opened a window for the files, EINA_FALSE
+ *         otherwise (e.g. no daemon is running)
+ */
+Eina_Bool daemon_client_open(const char *const files[]);
+
+#endif /* ! __EOVIM_DAEMON_H__ */
@@ -0,0 +1,189 @@
+/* This file is part of Eovim, which is under the MIT License ****************/
+
+#ifndef __EOVIM_GRID_H__
+#define __EOVIM_GRID_H__
+
+#include "eovim/types.h"
+
+/**
+ * @file grid.h
+ *
+ * The grid is the renderer-agnostic model of what neovim draws with the
+ * ext_linegrid protocol: a matrix of cells, the highlight attributes they
+ * refer to, and the position of the cursor. It only depends on Eina, so it
+ * can be driven without any display (e.g. to profile the decoding of redraw
+ * events).
+ *
+ * A renderer (i.e. the termview) consumes the grid by registering a backend,
+ * which is notified when the grid changes and asked to draw the rows that
+ * were modified when the grid is flushed.
+ */
+
+struct grid_cell {
+	char utf8[8]; /**< Raw UTF-8 text of the cell. It is NOT NUL-terminated */
+	uint32_t bytes; /**< Count of bytes in @p utf8 */
+	uint32_t style_id; /**< Highlight attribute (0 is the default one) */
+};
+
+struct grid_style {
+	union color fg_color;
+	union color bg_color;
+	union color sp_color;
+	Eina_Bool reverse;
+	Eina_Bool italic;
+	Eina_Bool bold;
+	Eina_Bool underline;
+	Eina_Bool undercurl;
+	Eina_Bool strikethrough;
+};
+
+/* Count of typed characters that can be drawn ahead of neovim */
+#define GRID_PREDICTIONS_MAX 32u
+
+struct grid_prediction {
+	unsigned int row;
+	unsigned int col;
+	struct grid_cell cell; /**< The character that was typed */
+};
+
+/**
+ * Functions a renderer implements to consume the grid. All of them are
+ * optional, and are called with the data given to grid_backend_set().
+ */
+struct grid_backend {
+	/** The grid was resized to @p cols x @p rows. All its cells are blank */
+	void (*resized)(void *data, unsigned int cols, unsigned int rows);
+	/** The grid was cleared. All its cells are blank */
+	void (*cleared)(void *data);
+	/** A highlight attribute or the default colors changed */
+	void (*styles_changed)(void *data);
+	/** The row @p row was modified since the last flush: draw @p cells */
+	void (*row_draw)(void *data, unsigned int row, const struct grid_cell *cells,
+			 unsigned int cols);
+};
+
+struct grid {
+	/* The cells are maintained as an Iliffe vector: cells[row][col] */
+	struct grid_cell **cells;
+
+	/* This per-row set of booleans is used to control which row has been
+	 * modified and needs to be drawn again by the backend. */
+	Eina_Bool *dirty_rows;
+
+	unsigned int cols;
+	unsigned int rows;
+
+	struct {
+		unsigned int x;
+		unsigned int y;
+	} cursor;
+
+	Eina_Hash *styles; /**< Highlight attributes, by identifier (t_int) */
+	Eina_Hash *hl_groups; /**< Highlight group name => struct grid_style */
+	union color default_fg;
+	union color default_bg;
+	union color default_sp;
+
+	/* Neovim changed the grid since the last flush: its batch of changes
+	 * may be applied only in part */
+	Eina_Bool batch_open;
+
+	/* Characters typed in insert mode, drawn before neovim echoes them.
+	 * See grid_predict() */
+	struct {
+		struct grid_prediction items[GRID_PREDICTIONS_MAX];
+		unsigned int count;
+		struct grid_cell *saved_row; /**< The row of the items, from neovim */
+		Eina_Bool applied; /**< The items are written in the cells */
+	} predictions;
+
+	const struct grid_backend *backend;
+	void *backend_data;
+};
+
+struct grid *grid_new(void);
+void grid_free(struct grid *grid);
+void grid_backend_set(struct grid *grid, const struct grid_backend *backend, void *data);
+
+void grid_resize(struct grid *grid, unsigned int cols, unsigned int rows);
+void grid_clear(struct grid *grid);
+void grid_line_edit(struct grid *grid, unsigned int row, unsigned int col, const char *text,
+		    size_t text_len, t_int style_id, size_t repeat);
+void grid_scroll(struct grid *grid, int top, int bot, int left, int right, int rows);
+void grid_cursor_goto(struct grid *grid, unsigned int to_x, unsigned int to_y);
+
+/**
+ * Draw, through the backend, all the rows that were modified since the last
+ * flush.
+ *
+ * @param[in] grid The grid to be flushed
+ * @return The count of rows that were drawn
+ */
+unsigned int grid_flush(struct grid *grid);
+
+/**
+ * Draw, through the backend, the row @p row if it was modified since the last
+ * flush. The other rows are left for the next flush.
+ *
+ * @param[in] grid The grid
+ * @param[in] row The row to be drawn
+ */
+void grid_row_flush(struct grid *grid, unsigned int row);
+
+/**
+ * Retrieve the highlight attribute @p style_id. It is created if it did not
+ * exist yet. grid_styles_changed() must be called once the attributes have
+ * been modified.
+ */
+struct grid_style *grid_style_get(struct grid *grid, t_int style_id);
+const struct grid_style *grid_style_find(const struct grid *grid, t_int style_id);
+void grid_styles_changed(struct grid *grid);
+void grid_default_colors_set(struct grid *grid, union color fg, union color bg, union color sp);
+Eina_Bool grid_hl_group_set(struct grid *grid, const char *name, t_int style_id);
+
+/**
+ * Write a character typed in insert mode at the cursor, before neovim echoes
+ * it, and move the cursor after it. The rest of the row is pushed to the
+ * right. Predictions do not outlive the next change from neovim: the cells
+ * they modified are restored first, and grid_predictions_reconcile() tells
+ * which of them still hold.
+ *
+ * @param[in] grid The grid
+ * @param[in] utf8 The character, a single cell wide
+ * @param[in] bytes Count of bytes in @p utf8
+ * @return EINA_TRUE if the character was predicted, EINA_FALSE if it cannot be
+ *         (e.g. the cursor is on the last column, where it would wrap, or
+ *         neovim did not flush its last changes yet)
+ */
+Eina_Bool grid_predict(struct grid *grid, const char *utf8, size_t bytes);
+
+/**
+ * Once neovim has sent a batch of changes, keep the predictions it did not
+ * process yet and draw them again. Those it processed are dropped. If neovim
+ * drew something else than a prediction, all of them are dropped.
+ */
+void grid_predictions_reconcile(struct grid *grid);
+
+/**
+ * Restore the cells modified by the predictions, and forget them
+ */
+void grid_predictions_drop(struct grid *grid);
+
+/**
+ * Pack the contents of the grid (its dimensions, cells, highlight attributes
+ * and default colors) as a single msgpack object. Highlight groups and the
+ * cursor are not part of it.
+ */
+void grid_snapshot_pack(const struct grid *grid, msgpack_packer *pk);
+
+/**
+ * Restore the contents of the grid from an object that was packed by
+ * grid_snapshot_pack(). The grid is resized if needed, and all its rows are
+ * to be drawn by the next flush.
+ *
+ * @return EINA_TRUE on success, EINA_FALSE if @p obj is not a valid snapshot.
+ *         The grid is left untouched if the snapshot is invalid.
+ */
+Eina_Bool grid_snapshot_load(struct grid *grid, const msgpack_object *obj);
+
+#endif /* ! __EOVIM_GRID_H__ */
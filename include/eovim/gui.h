@@ -19,6 +19,7 @@ struct gui {
 	struct cursor *cursor;
 	struct popupmenu *active_popup;
 	struct cmdline *cmdline;
+	Ecore_Idler *prewarm; /**< Creates the widgets above after the first frame */
 
 	struct {
 		Eina_Stringshare *name;
@@ -38,6 +39,23 @@ struct gui {
 		Ecore_Pos_Map cursor_animation_style;
 	} theme;
 
+	/** Drop auto-repeated keys while neovim did not redraw after the
+	 * previous input */
+	Eina_Bool key_repeat_throttle;
+	/** Draw the characters typed in insert mode before neovim echoes them */
+	Eina_Bool predictive_echo;
+
+	/* Rendering counters. They are sampled by the performance HUD */
+	struct {
+		unsigned int frames; /**< Frames rendered after a flush, while the HUD is shown */
+		unsigned int flushes; /**< Calls to termview_flush() */
+		unsigned int dirty_rows; /**< Rows re-written by termview_flush() */
+		unsigned int style_updates; /**< Calls to termview_style_update() */
+		double flush_time; /**< Total duration (in seconds) of the flushes */
+		double flush_max; /**< Longest flush since the HUD was last refreshed */
+	} stats;
+	struct hud *hud; /**< Performance HUD. NULL when disabled */
+
 	struct nvim *nvim;
 	Eina_Inarray *tabs;
 
@@ -81,7 +99,7 @@ void gui_del(struct gui *gui);
 void gui_resize(struct gui *gui, unsigned int cols, unsigned int rows);
 void gui_busy_set(struct gui *gui, Eina_Bool busy);
 void gui_die(struct gui *gui, const char *fmt, ...) EINA_PRINTF(2, 3);
-void gui_default_colors_set(struct gui *gui, union color fg, union color bg, union color sp);
+void gui_default_colors_set(struct gui *gui, union color fg, union color bg);
 
 void gui_bell_ring(struct gui *gui);
 
@@ -110,8 +128,16 @@ void gui_caps_lock_alert(struct gui *gui);
 void gui_caps_lock_dismiss(struct gui *gui);
 Eina_Bool gui_caps_lock_warning_get(const struct gui *gui);
 
+void gui_hud_enabled_set(struct gui *gui, Eina_Bool enabled);
+
+void gui_placeholder_show(struct gui *gui);
 void gui_ready_set(struct gui *gui);
 void gui_mode_update(struct gui *gui, const struct mode *mode);
+
+/**
+ * Paste the contents of the clipboard into neovim. See paste_start()
+ */
+void gui_paste(struct gui *gui);
 Eina_Bool gui_cmdline_enabled_get(const struct gui *gui);
 
 #endif /* ! __EOVIM_GUI_H__ */
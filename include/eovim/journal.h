@@ -0,0 +1,81 @@
+/* This file is part of Eovim, which is under the MIT License ****************/
+
+#ifndef __EOVIM_JOURNAL_H__
+#define __EOVIM_JOURNAL_H__
+
+#include "eovim/types.h"
+
+/**
+ * @file journal.h
+ *
+ * The journal keeps the last inputs (keys and mouse events) of a neovim
+ * instance, to diagnose the inputs that are lost, reordered or late. Each
+ * entry goes through these stages:
+ *
+ * 1. received: eovim got the event from the windowing system;
+ * 2. sent: eovim wrote it to neovim, within a request;
+ * 3. answered: neovim answered this request;
+ * 4. drawn: eovim drew the first redraw that came after the answer.
+ *
+ * The time spent between two stages tells whether an input was held by
+ * eovim, by the pipe (neovim answers inputs before processing them) or by
+ * neovim itself. Auto-repeated keys that eovim dropped never leave the
+ * first stage.
+ *
+ * The journal has a fixed size: the oldest entries are overwritten. It can
+ * be retrieved with the "journal" request (see :EovimJournal), and is
+ * written on the standard error if eovim crashes.
+ */
+
+/* Count of entries each journal keeps */
+#define JOURNAL_SIZE 256u
+
+enum journal_kind {
+	JOURNAL_KIND_KEY = 0, /**< Keys, with nvim_input() */
+	JOURNAL_KIND_MOUSE, /**< Press, drag and release of a mouse button */
+	JOURNAL_KIND_WHEEL, /**< Steps of the wheel */
+	__JOURNAL_KIND_LAST /* Sentinel */
+};
+
+Eina_Bool journal_init(void);
+void journal_shutdown(void);
+
+struct journal *journal_new(void);
+void journal_free(struct journal *journal);
+
+/**
+ * Record an input that was just received
+ *
+ * @param[in] journal The journal of the neovim instance
+ * @param[in] kind How the input will be sent to neovim
+ * @param[in] input What is sent to neovim (e.g. "<C-a>"). It is truncated
+ * @param[in] size Count of bytes of @p input
+ * @param[in] dropped EINA_TRUE if the input will not be sent at all
+ */
+void journal_input_add(struct journal *journal, enum journal_kind kind, const char *input,
+		       size_t size, Eina_Bool dropped);
+
+/**
+ * All the received inputs of kind @p kind were sent by the request @p req_id.
+ * If there were none, @p req_id continues the previous request of this kind,
+ * whose inputs are now answered with @p req_id.
+ */
+void journal_sent(struct journal *journal, enum journal_kind kind, uint32_t req_id);
+
+/**
+ * Neovim answered the request @p req_id. It may not be an input
+ */
+void journal_answered(struct journal *journal, uint32_t req_id);
+
+/**
+ * A redraw from neovim was drawn. All the answered inputs were processed
+ */
+void journal_drawn(struct journal *journal);
+
+/**
+ * Write the entries of @p journal in @p pk, from the oldest to the most
+ * recent, as an array of strings
+ */
+void journal_pack(const struct journal *journal, msgpack_packer *pk);
+
+#endif /* ! __EOVIM_JOURNAL_H__ */
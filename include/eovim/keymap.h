@@ -5,13 +5,44 @@
 
 #include <Eina.h>
 
+/**
+ * @file keymap.h
+ *
+ * Translation of the special keys (arrows, function keys, ...) to the
+ * notation of neovim (see :help key-notation). The tables are generated at
+ * build time by keymap-gen from src/keymap_keys.h, so translating a key is a
+ * single lookup, without hashing into an Eina_Hash nor formatting strings.
+ */
+
+/** Modifiers of a special key. Combined, they index struct keymap::inputs */
+enum keymap_mod {
+	KEYMAP_MOD_CTRL = (1 << 0), /**< <C-...> */
+	KEYMAP_MOD_SHIFT = (1 << 1), /**< <S-...> */
+	KEYMAP_MOD_SUPER = (1 << 2), /**< <D-...> */
+	KEYMAP_MOD_ALT = (1 << 3), /**< <A-...> */
+};
+
+/** Count of combinations of the modifiers */
+#define KEYMAP_MODS_COUNT 16u
+
+struct keymap_input {
+	const unsigned int size; /**< Length of @p str */
+	const char *const str; /**< E.g. <C-S-PageUp> */
+};
+
 struct keymap {
-	const unsigned int size;
-	const char *const name;
+	const char *const name; /**< Name of the key for neovim. E.g. PageUp */
+	/** Input to be sent to neovim, for each combination of modifiers */
+	const struct keymap_input inputs[KEYMAP_MODS_COUNT];
+	const Eina_Bool caps_lock; /**< The key toggles the caps lock. Not sent */
 };
 
-Eina_Bool keymap_init(void);
-void keymap_shutdown(void);
+/**
+ * Retrieve the translation of a special key.
+ *
+ * @param[in] input Name of the key, as given by Ecore_Event_Key::key
+ * @return The translation of @p input, or NULL if it is not a special key
+ */
 const struct keymap *keymap_get(const char *input);
 
 #endif /* ! __EOVIM_KEYMAP_H__ */
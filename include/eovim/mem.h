@@ -0,0 +1,65 @@
+/* This file is part of Eovim, which is under the MIT License ****************/
+
+#ifndef __EOVIM_MEM_H__
+#define __EOVIM_MEM_H__
+
+#include <Eina.h>
+
+/**
+ * @file mem.h
+ *
+ * Accounting of the memory used by eovim's subsystems. Allocations are not
+ * wrapped: the code that allocates or releases memory reports it here, so we
+ * can tell where memory goes in long-running sessions.
+ */
+
+enum mem_pool {
+	MEM_POOL_GRID = 0, /**< Cells and dirty rows of the grid */
+	MEM_POOL_TEXTBLOCK, /**< Markup rendered in the termview's textblock */
+	MEM_POOL_STYLES, /**< Highlight attributes */
+	MEM_POOL_HL_GROUPS, /**< Highlight groups names */
+	MEM_POOL_KIND_STYLES, /**< Styles of the completion kinds */
+	MEM_POOL_RPC, /**< msgpack unpacker and send buffer */
+	MEM_POOL_REQUESTS, /**< Pending requests to neovim */
+	MEM_POOL_COMPLETION, /**< Items of the completion popup */
+	MEM_POOL_WILDMENU, /**< Items of the wildmenu */
+	__MEM_POOL_LAST /* Sentinel */
+};
+
+struct mem_stats {
+	size_t current; /**< Bytes currently in use */
+	size_t peak; /**< Highest value ever reached by @p current */
+	uint64_t allocations; /**< Count of allocations since startup */
+};
+
+/**
+ * Account for @p bytes that were just allocated by the pool @p pool
+ */
+void mem_alloc_account(enum mem_pool pool, size_t bytes);
+
+/**
+ * Account for @p bytes that were just released by the pool @p pool
+ */
+void mem_free_account(enum mem_pool pool, size_t bytes);
+
+/**
+ * Set the amount of memory used by one of the users of the pool @p pool (e.g.
+ * one of the neovim instances). This is meant for buffers that are managed by
+ * third-party libraries, and which can only be queried for their size.
+ * Growing the pool counts as an allocation.
+ *
+ * @param[in] pool The memory pool
+ * @param[in,out] owned The amount previously set by this user. It is updated.
+ * @param[in] bytes The amount of memory now used by this user
+ */
+void mem_usage_update(enum mem_pool pool, size_t *owned, size_t bytes);
+
+const struct mem_stats *mem_stats_get(enum mem_pool pool);
+const char *mem_pool_name_get(enum mem_pool pool);
+
+/**
+ * Print the memory used by each pool on the standard output
+ */
+void mem_report(void);
+
+#endif /* ! __EOVIM_MEM_H__ */
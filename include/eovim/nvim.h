@@ -6,6 +6,8 @@
 #include <eovim/types.h>
 #include <eovim/nvim_helper.h>
 #include <eovim/gui.h>
+#include <eovim/grid.h>
+#include <eovim/rpc.h>
 
 #include <Eina.h>
 #include <Ecore.h>
@@ -19,31 +21,38 @@
 	(NVIM_VERSION_MAJOR(Nvim) == (Major) && NVIM_VERSION_MINOR(Nvim) == (Minor) &&             \
 	 NVIM_VERSION_PATCH(Nvim) == (Patch))
 
+/**
+ * Neovim reserves this channel to its standard input/output, which is what eovim
+ * talks to (--embed). Our runtime needs it before we could ask neovim.
+ */
+#define NVIM_STDIO_CHANNEL 1u
+
 struct nvim {
+	EINA_INLIST; /**< All the neovim instances of the process are listed */
 	struct gui gui;
 	struct version version; /**< The neovim's version */
 	uint64_t channel;
 	const struct options *opts;
 
-	Ecore_Exe *exe;
+	Ecore_Exe *exe; /**< NULL once the neovim process has exited */
 
 	Ecore_Event_Handler *event_handlers[4];
 	Eina_Inlist *requests;
+	struct nvim_api_batch *batch; /**< Batch of calls being composed, if any */
+	struct paste *paste; /**< Text being pasted, if any */
+	struct clipboard *clipboard; /**< Selections set by neovim */
+	Ecore_Idler *dispatch_idler; /**< Processes the messages left by a slice */
 
-	msgpack_unpacker unpacker;
-
-	/* The following msgpack structures must be handled on the main loop only */
-	msgpack_sbuffer sbuffer;
-	msgpack_packer packer;
-	uint32_t request_id;
+	struct rpc rpc;
+	struct grid *grid; /**< Model of the grid, rendered by the termview */
+	struct journal *journal; /**< Last inputs sent to neovim */
 
 	Eina_Hash *modes;
 
-	Eina_Hash *hl_groups;
-
 	/* Map of strings that associates to a kind identifier (used by completion) to
 	 * a style string that is compatible with Evas_textblock */
 	Eina_Hash *kind_styles;
+	size_t kind_styles_mem; /**< Share of MEM_POOL_KIND_STYLES */
 	/* Map of strings that associates a cmdline prompt to
 	 * a style string that is compatible with Evas_textblock */
 	Eina_Hash *cmdline_styles;
@@ -58,9 +67,23 @@ struct nvim {
 	} features;
 };
 
+/**
+ * Spawn a neovim process, and create the window it is attached to. Several
+ * instances can live in the same process. An instance is released once its
+ * neovim process exited and its window was deleted: closing the window
+ * terminates neovim, and neovim exiting deletes the window.
+ *
+ * @param[in] opts The options of the instance. They must outlive it.
+ * @param[in] args Arguments forwarded to neovim. NULL-terminated
+ * @return The new neovim handle, or NULL on failure
+ */
 struct nvim *nvim_new(const struct options *opts, const char *const args[]);
-void nvim_free(struct nvim *nvim);
-uint32_t nvim_next_uid_get(struct nvim *nvim);
+
+/**
+ * Release all the neovim instances. This is meant to be called once the main
+ * loop is over.
+ */
+void nvim_free_all(void);
 void nvim_mouse_enabled_set(struct nvim *nvim, Eina_Bool enable);
 Eina_Bool nvim_mouse_enabled_get(const struct nvim *nvim);
 void nvim_attach(struct nvim *nvim);
@@ -13,6 +13,38 @@ Eina_Bool nvim_api_get_api_info(struct nvim *nvim, f_nvim_api_cb cb, void *data)
 Eina_Bool nvim_api_ui_try_resize(struct nvim *nvim, unsigned int width, unsigned height);
 Eina_Bool nvim_api_ui_ext_set(struct nvim *nvim, const char *key, Eina_Bool enabled);
 Eina_Bool nvim_api_input(struct nvim *nvim, const char *input, size_t input_size);
+
+/**
+ * Send a mouse event to neovim, without encoding it as a key sequence.
+ *
+ * @param[in] nvim The neovim handle
+ * @param[in] button "left", "right", "middle" or "wheel"
+ * @param[in] action "press", "drag" or "release". For the wheel: "up",
+ *            "down", "left" or "right"
+ * @param[in] modifier Modifiers, with the notation of keys (e.g. "C-S"). May
+ *            be empty
+ * @param[in] grid The grid the event happened on, 0 without ext_multigrid
+ * @param[in] row Row of the cell under the pointer
+ * @param[in] col Column of the cell under the pointer
+ * @return EINA_TRUE on success, EINA_FALSE on failure.
+ */
+Eina_Bool nvim_api_input_mouse(struct nvim *nvim, const char *button, const char *action,
+			       const char *modifier, unsigned int grid, unsigned int row,
+			       unsigned int col);
+/**
+ * Paste @p data with nvim_paste. It is inserted as a whole, not as typed keys.
+ *
+ * @param[in] nvim The neovim handle
+ * @param[in] data Text to be pasted
+ * @param[in] size Count of bytes of @p data
+ * @param[in] phase -1 for a paste made of a single call. Otherwise, 1 for the
+ *            first chunk of a stream, 2 for the next ones and 3 for the last
+ * @param[in] func Called with the result: false if the paste must stop
+ * @param[in] func_data Context passed to @p func
+ * @return EINA_TRUE on success, EINA_FALSE on failure.
+ */
+Eina_Bool nvim_api_paste(struct nvim *nvim, const char *data, size_t size, int phase,
+			 f_nvim_api_cb func, void *func_data);
 Eina_Bool nvim_api_get_var(struct nvim *nvim, const char *var, f_nvim_api_cb func, void *func_data);
 
 Eina_Bool nvim_api_eval(struct nvim *nvim, const char *input, size_t input_size, f_nvim_api_cb func,
@@ -23,6 +55,33 @@ Eina_Bool nvim_api_command_output(struct nvim *nvim, const char *input, size_t i
 Eina_Bool nvim_api_command(struct nvim *nvim, const char *input, size_t input_size,
 			   f_nvim_api_cb func, void *func_data);
 
+/**
+ * Start composing a batch of calls. Until nvim_api_batch_end() is called,
+ * nvim_api_command(), nvim_api_command_output(), nvim_api_eval(),
+ * nvim_api_get_var(), nvim_api_ui_ext_set() and nvim_api_paste() do not send
+ * a request each: their calls are appended to the batch instead. Their
+ * callbacks are still called with their own result, or NULL if they failed or
+ * were not run.
+ *
+ * Inputs are never batched: nvim_input and nvim_input_mouse are run by neovim
+ * as soon as they are read, even while it is busy, and nvim_call_atomic is not.
+ *
+ * @param[in] nvim The neovim handle
+ * @return EINA_TRUE on success, EINA_FALSE on failure (e.g. a batch is
+ *         already being composed)
+ */
+Eina_Bool nvim_api_batch_begin(struct nvim *nvim);
+
+/**
+ * Send all the calls of the batch at once, with nvim_call_atomic.
+ *
+ * @param[in] nvim The neovim handle
+ * @param[in] func Called with the results of all the calls. May be NULL
+ * @param[in] func_data Context passed to @p func
+ * @return EINA_TRUE on success, EINA_FALSE on failure.
+ */
+Eina_Bool nvim_api_batch_end(struct nvim *nvim, f_nvim_api_batch_cb func, void *func_data);
+
 struct request *nvim_api_request_find(const struct nvim *nvim, uint32_t req_id);
 void nvim_api_request_free(struct nvim *nvim, struct request *req);
 void nvim_api_request_call(struct nvim *nvim, const struct request *req,
@@ -10,4 +10,26 @@ Eina_Bool nvim_helper_autocmd_do(struct nvim *nvim, const char *event, f_nvim_ap
 
 Eina_Bool nvim_helper_config_reload(struct nvim *nvim);
 
+/**
+ * Apply the new value of a single configuration variable
+ *
+ * @param[in] nvim The neovim handle
+ * @param[in] name Name of the variable, without the g: prefix
+ * @param[in] value The new value of the variable
+ * @return EINA_TRUE on success, EINA_FALSE on failure.
+ */
+Eina_Bool nvim_helper_config_set(struct nvim *nvim, const msgpack_object_str *name,
+				 const msgpack_object *value);
+
+/**
+ * Make neovim edit files, as if they were given on its command-line from
+ * another working directory.
+ *
+ * @param[in] nvim The neovim handle
+ * @param[in] args The array [cwd, [file...]]. Files may be relative to cwd
+ * @return EINA_TRUE on success, EINA_FALSE on failure (e.g. @p args is not
+ *         correctly formatted, in which case nothing was sent).
+ */
+Eina_Bool nvim_helper_files_open(struct nvim *nvim, const msgpack_object_array *args);
+
 #endif /* ! __EOVIM_NVIM_HELPER_H__ */
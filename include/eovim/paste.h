@@ -0,0 +1,38 @@
+/* This file is part of Eovim, which is under the MIT License ****************/
+
+#ifndef __EOVIM_PASTE_H__
+#define __EOVIM_PASTE_H__
+
+#include "eovim/types.h"
+
+/**
+ * @file paste.h
+ *
+ * Text pasted in eovim (from the clipboard, or dropped on the window) is given
+ * to neovim with nvim_paste, which inserts it as a whole instead of as typed
+ * keys: no mapping nor abbreviation is triggered. Large texts are streamed in
+ * chunks. A chunk is only sent once neovim processed the previous one, and at
+ * most one chunk is packed per iteration of the main loop, so neither eovim
+ * nor neovim freeze while pasting.
+ */
+
+/**
+ * Start pasting @p text into neovim. The text is copied.
+ *
+ * @param[in] nvim The neovim handle
+ * @param[in] text The text to be pasted. It does not need to be NUL-terminated
+ * @param[in] size Count of bytes of @p text
+ * @return EINA_TRUE if the paste started, EINA_FALSE on failure (e.g. another
+ *         paste is still in progress)
+ */
+Eina_Bool paste_start(struct nvim *nvim, const char *text, size_t size);
+
+/**
+ * Stop sending the paste in progress, if any. The chunks neovim already
+ * received stay pasted.
+ *
+ * @param[in] nvim The neovim handle
+ */
+void paste_cancel(struct nvim *nvim);
+
+#endif /* ! __EOVIM_PASTE_H__ */
@@ -0,0 +1,114 @@
+/* This file is part of Eovim, which is under the MIT License ****************/
+
+#ifndef __EOVIM_RPC_H__
+#define __EOVIM_RPC_H__
+
+#include <Eina.h>
+#include <msgpack.h>
+
+/**
+ * @file rpc.h
+ *
+ * Transport of the msgpack-rpc protocol: it decodes the stream of bytes
+ * received from the peer into requests, responses and notifications, and
+ * buffers the messages to be sent to the peer. It does not know anything about
+ * the channel itself (pipes, sockets, ...) nor about what the messages mean.
+ *
+ * See https://github.com/msgpack-rpc/msgpack-rpc/blob/master/spec.md
+ */
+
+/**
+ * Functions called by the RPC client. They are all mandatory, and are called
+ * with the data given to rpc_setup().
+ */
+struct rpc_handlers {
+	/** The request [0, req_id, method, args] was received */
+	Eina_Bool (*request)(void *data, uint32_t req_id, Eina_Stringshare *method,
+			     const msgpack_object_array *args);
+	/** The response [1, req_id, error, result] was received. @p result is
+	 * NULL when the peer reported an error (it has already been logged) */
+	Eina_Bool (*response)(void *data, uint32_t req_id, const msgpack_object *result);
+	/** The notification [2, method, args] was received */
+	Eina_Bool (*notification)(void *data, Eina_Stringshare *method,
+				  const msgpack_object_array *args);
+	/** Write @p size bytes to the peer */
+	Eina_Bool (*send)(void *data, const void *bytes, size_t size);
+};
+
+struct rpc {
+	const struct rpc_handlers *handlers;
+	void *data;
+
+	msgpack_unpacker unpacker;
+
+	/* The following msgpack structures must be handled on the main loop only */
+	msgpack_sbuffer sbuffer;
+	msgpack_packer packer;
+	uint32_t request_id;
+
+	size_t mem; /**< Share of MEM_POOL_RPC */
+
+	/* Amount of bytes that went through the RPC channel */
+	struct {
+		size_t received;
+		size_t sent;
+	} bytes;
+};
+
+Eina_Bool rpc_setup(struct rpc *rpc, const struct rpc_handlers *handlers, void *data);
+void rpc_cleanup(struct rpc *rpc);
+
+/**
+ * @return A new identifier for a request to be sent to the peer
+ */
+uint32_t rpc_next_uid_get(struct rpc *rpc);
+
+/**
+ * Send the messages that were packed with the rpc's packer to the peer, then
+ * empty the buffer.
+ *
+ * @param[in] rpc The RPC client
+ * @return EINA_TRUE on success, EINA_FALSE on failure.
+ */
+Eina_Bool rpc_flush(struct rpc *rpc);
+
+/**
+ * Feed bytes received from the peer to the RPC client. The handlers are called
+ * for each message that was completely received. Incomplete messages are kept
+ * until the next call.
+ *
+ * @param[in] rpc The RPC client
+ * @param[in] bytes The bytes received from the peer
+ * @param[in] size Count of bytes in @p bytes
+ * @return EINA_FALSE if the stream is corrupted, EINA_TRUE otherwise.
+ */
+Eina_Bool rpc_data_process(struct rpc *rpc, const void *bytes, size_t size);
+
+/**
+ * Keep bytes received from the peer, without processing them. The messages
+ * they complete are processed by rpc_data_dispatch().
+ *
+ * @param[in] rpc The RPC client
+ * @param[in] bytes The bytes received from the peer
+ * @param[in] size Count of bytes in @p bytes
+ * @return EINA_FALSE if they could not be kept, EINA_TRUE otherwise.
+ */
+Eina_Bool rpc_data_feed(struct rpc *rpc, const void *bytes, size_t size);
+
+/**
+ * Call the handlers for the messages that were completely received, until
+ * @p budget seconds are elapsed. A message is never processed partially, so
+ * the budget may be exceeded by the last one. The budget is also exceeded
+ * while more than a few megabytes are left to process, so the bytes kept by
+ * rpc_data_feed() are bounded even if the peer sends faster than we process.
+ *
+ * @param[in] rpc The RPC client
+ * @param[in] budget Time (in seconds) after which no message is processed. If
+ *            negative, all the messages are processed.
+ * @param[out] pending Set to EINA_TRUE when the budget ran out, as messages
+ *             may be left. May be NULL
+ * @return EINA_FALSE if the stream is corrupted, EINA_TRUE otherwise.
+ */
+Eina_Bool rpc_data_dispatch(struct rpc *rpc, double budget, Eina_Bool *pending);
+
+#endif /* ! __EOVIM_RPC_H__ */
@@ -0,0 +1,40 @@
+/* This file is part of Eovim, which is under the MIT License ****************/
+
+#ifndef __EOVIM_SNAPSHOT_H__
+#define __EOVIM_SNAPSHOT_H__
+
+#include "eovim/types.h"
+
+/**
+ * @file snapshot.h
+ *
+ * A snapshot is the last screen displayed by neovim: the grid (cells,
+ * highlight attributes, default colors) and the font it was rendered with.
+ * It is saved when neovim exits, in the user's cache directory, and is
+ * keyed by the working directory of eovim.
+ *
+ * When eovim is started again from the same directory, the snapshot is shown
+ * right away, dimmed, while neovim starts. The first frame drawn by neovim
+ * replaces it.
+ *
+ * As it holds what was on screen, a snapshot is only readable by the user.
+ * Old snapshots are pruned each time one is saved, and --no-snapshot disables
+ * them altogether.
+ */
+
+/**
+ * Save the screen of @p nvim, so it can be shown by the next eovim started
+ * from the same working directory. Errors are only logged.
+ */
+void snapshot_save(const struct nvim *nvim);
+
+/**
+ * Show the snapshot of the working directory as a placeholder in the window
+ * of @p nvim. This must be called before neovim draws anything.
+ *
+ * @return EINA_TRUE if a snapshot was shown, EINA_FALSE otherwise (e.g.
+ *         there is no snapshot, or it does not fit the requested geometry)
+ */
+Eina_Bool snapshot_load(struct nvim *nvim);
+
+#endif /* ! __EOVIM_SNAPSHOT_H__ */
@@ -14,8 +14,22 @@ struct options;
 
 typedef int64_t t_int;
 typedef Eina_Bool (*f_event_cb)(struct nvim *nvim, const msgpack_object_array *args);
+
+/**
+ * Called with the result of a call. @p result is NULL when neovim reported an
+ * error, which was already logged.
+ */
 typedef void (*f_nvim_api_cb)(struct nvim *nvim, void *data, const msgpack_object *result);
 
+/**
+ * Called with the results of a batch of calls. When the call at index
+ * @p error_index failed, @p results only holds the results of the calls
+ * before it. @p error_index is NVIM_API_BATCH_NO_ERROR if all calls succeeded.
+ */
+typedef void (*f_nvim_api_batch_cb)(struct nvim *nvim, void *data,
+				    const msgpack_object_array *results, unsigned int error_index);
+#define NVIM_API_BATCH_NO_ERROR UINT_MAX
+
 #define COLOR_DEFAULT UINT32_C(0)
 
 union color {
@@ -71,6 +85,11 @@ struct options {
 
 	Eina_Bool fullscreen;
 	Eina_Bool maximized; /**< Eovim will run in a maximized window */
+	Eina_Bool bench_startup; /**< Measure the startup time, then exit */
+	Eina_Bool mem_report; /**< Print the memory used by each subsystem on exit */
+	Eina_Bool daemon; /**< Keep warm neovim instances for the clients */
+	Eina_Bool client; /**< Ask the daemon to open the files */
+	Eina_Bool no_snapshot; /**< Neither show nor save the last screen */
 };
 
 #endif /* ! __EOVIM_TYPES_H__ */
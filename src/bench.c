@@ -0,0 +1,64 @@
+/* This file is part of Eovim, which is under the MIT License ****************/
+
+#include "eovim/bench.h"
+
+#include <time.h>
+
+static const char *const _stage_names[__BENCH_STAGE_LAST] = {
+	[BENCH_STAGE_PROCESS] = "process loaded",
+	[BENCH_STAGE_MAIN] = "efl initialized",
+	[BENCH_STAGE_MODULES] = "modules initialized",
+	[BENCH_STAGE_THEME] = "edje theme loaded",
+	[BENCH_STAGE_GUI] = "nvim spawned, gui created",
+	[BENCH_STAGE_API_INFO] = "nvim api info decoded",
+	[BENCH_STAGE_ATTACH_ACK] = "ui attach acknowledged",
+	[BENCH_STAGE_UI_ATTACHED] = "ui attached",
+	[BENCH_STAGE_CONFIG] = "config requested",
+	[BENCH_STAGE_FIRST_FLUSH] = "first termview flush",
+	[BENCH_STAGE_FIRST_FRAME] = "first frame rendered",
+};
+
+/* Timestamps of each stage, in seconds. Zero means "not reached". */
+static double _stamps[__BENCH_STAGE_LAST];
+
+static double _now(void)
+{
+	/* We don't use ecore_time_get(), as the very first stages are reached
+	 * before ecore is even initialized */
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+void bench_mark(const enum bench_stage stage)
+{
+	EINA_SAFETY_ON_FALSE_RETURN(stage < __BENCH_STAGE_LAST);
+
+	if (_stamps[stage] <= 0.0)
+		_stamps[stage] = _now();
+}
+
+Eina_Bool bench_reached(const enum bench_stage stage)
+{
+	EINA_SAFETY_ON_FALSE_RETURN_VAL(stage < __BENCH_STAGE_LAST, EINA_FALSE);
+	return _stamps[stage] > 0.0;
+}
+
+void bench_report(void)
+{
+	const double origin = _stamps[BENCH_STAGE_PROCESS];
+	double prev = origin;
+
+	printf("%-28s %12s %12s\n", "Startup stage", "Delta (ms)", "Total (ms)");
+	for (unsigned int i = 0u; i < __BENCH_STAGE_LAST; i++) {
+		const double stamp = _stamps[i];
+		if (stamp <= 0.0) {
+			printf("%-28s %12s %12s\n", _stage_names[i], "-", "-");
+			continue;
+		}
+		printf("%-28s %12.3f %12.3f\n", _stage_names[i], (stamp - prev) * 1e3,
+		       (stamp - origin) * 1e3);
+		prev = stamp;
+	}
+	fflush(stdout);
+}
@@ -0,0 +1,75 @@
+/* This file is part of Eovim, which is under the MIT License ****************/
+
+#include "eovim/cache.h"
+#include "eovim/log.h"
+
+#include <Ecore_File.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <unistd.h>
+
+Eina_Bool cache_path_get(char *const path, const size_t size, const char *const name)
+{
+	const char *const cache = getenv("XDG_CACHE_HOME");
+	int len;
+
+	/* XDG requires absolute paths. Relative ones must be ignored */
+	if (cache && (cache[0] == '/'))
+		len = snprintf(path, size, "%s/%s", cache, name);
+	else
+		len = snprintf(path, size, "%s/.cache/%s", eina_environment_home_get(), name);
+	if (EINA_UNLIKELY((len < 0) || ((size_t)len >= size))) {
+		ERR("The path of the cache file '%s' is too long", name);
+		return EINA_FALSE;
+	}
+	return EINA_TRUE;
+}
+
+Eina_Bool cache_write(const char *const path, const msgpack_sbuffer *const sbuf)
+{
+	char dir[PATH_MAX];
+	char tmp_path[PATH_MAX + 16];
+
+	/* Create the directory of the file, if needed */
+	const char *const sep = strrchr(path, '/');
+	if (EINA_UNLIKELY((!sep) || ((size_t)(sep - path) >= sizeof(dir)))) {
+		ERR("Invalid path '%s'", path);
+		return EINA_FALSE;
+	}
+	const size_t dir_len = (size_t)(sep - path);
+	memcpy(dir, path, dir_len);
+	dir[dir_len] = '\0';
+	if (EINA_UNLIKELY(!ecore_file_mkpath(dir))) {
+		ERR("Failed to create the directory '%s'", dir);
+		return EINA_FALSE;
+	}
+
+	/* The files may hold what was on screen: only the user can read them */
+	snprintf(tmp_path, sizeof(tmp_path), "%s.%i", path, (int)getpid());
+	const int fd = open(tmp_path, O_CREAT | O_WRONLY | O_TRUNC | O_CLOEXEC, 0600);
+	if (EINA_UNLIKELY(fd < 0)) {
+		ERR("Failed to open '%s': %s", tmp_path, strerror(errno));
+		return EINA_FALSE;
+	}
+	FILE *const file = fdopen(fd, "wb");
+	if (EINA_UNLIKELY(!file)) {
+		ERR("Failed to open '%s': %s", tmp_path, strerror(errno));
+		close(fd);
+		goto fail;
+	}
+	const Eina_Bool written = (fwrite(sbuf->data, 1u, sbuf->size, file) == sbuf->size);
+	if (EINA_UNLIKELY((fclose(file) != 0) || !written)) {
+		ERR("Failed to write '%s'", tmp_path);
+		goto fail;
+	}
+	if (EINA_UNLIKELY(rename(tmp_path, path) != 0)) {
+		ERR("Failed to rename '%s' to '%s': %s", tmp_path, path, strerror(errno));
+		goto fail;
+	}
+	DBG("Wrote %zu bytes in '%s'", sbuf->size, path);
+	return EINA_TRUE;
+
+fail:
+	unlink(tmp_path);
+	return EINA_FALSE;
+}
@@ -0,0 +1,325 @@
+/* This file is part of Eovim, which is under the MIT License ****************/
+
+#include "eovim/clipboard.h"
+#include "eovim/nvim.h"
+#include "eovim/nvim_request.h"
+#include "eovim/msgpack_helper.h"
+#include "eovim/log.h"
+
+/* Delay (in seconds) after which a selection that could not be read is
+ * considered empty. Neovim is blocked until it gets an answer */
+#define CLIPBOARD_TIMEOUT 0.5
+
+enum selection_id {
+	SELECTION_CLIPBOARD, /**< Register "+" */
+	SELECTION_PRIMARY, /**< Register "*" */
+	SELECTION_LAST,
+};
+
+struct selection {
+	Eina_Strbuf *text; /**< Lines set by neovim, as given to the selection */
+	Eina_Stringshare *regtype;
+	Eina_Bool owned; /**< The selection is still the one neovim set */
+};
+
+/* A read of a selection cannot be cancelled: it is kept until Elementary
+ * calls it back, even if neovim got its answer meanwhile */
+struct read {
+	struct nvim *nvim; /**< NULL once neovim was answered */
+	Ecore_Timer *timer;
+	uint32_t req_id;
+};
+
+struct clipboard {
+	struct selection selections[SELECTION_LAST];
+
+	/* Neovim blocks on a read: it waits for at most one at a time */
+	struct read *read;
+};
+
+/* Reads that were not called back yet */
+static Eina_List *_reads = NULL;
+
+static const Elm_Sel_Type _sel_types[SELECTION_LAST] = {
+	[SELECTION_CLIPBOARD] = ELM_SEL_TYPE_CLIPBOARD,
+	[SELECTION_PRIMARY] = ELM_SEL_TYPE_PRIMARY,
+};
+
+static struct clipboard *_clipboard_get(struct nvim *const nvim)
+{
+	if (!nvim->clipboard) {
+		nvim->clipboard = calloc(1, sizeof(struct clipboard));
+		if (EINA_UNLIKELY(!nvim->clipboard))
+			CRI("Failed to allocate memory");
+	}
+	return nvim->clipboard;
+}
+
+static int _selection_id_get(const msgpack_object *const obj)
+{
+	MPACK_STRING_CHECK(obj, return -1);
+	const msgpack_object_str *const reg = &(obj->via.str);
+	if (reg->size == 1u) {
+		if (reg->ptr[0] == '+')
+			return SELECTION_CLIPBOARD;
+		if (reg->ptr[0] == '*')
+			return SELECTION_PRIMARY;
+	}
+	ERR("Unsupported register '%.*s'", (int)reg->size, reg->ptr);
+	return -1;
+}
+
+static void _selection_loss_cb(void *const data, const Elm_Sel_Type type)
+{
+	struct clipboard *const clipboard = ((struct nvim *)data)->clipboard;
+	if (!clipboard)
+		return;
+
+	/* Another client set the selection: it must be read again */
+	for (unsigned int i = 0u; i < SELECTION_LAST; i++) {
+		if (_sel_types[i] == type)
+			clipboard->selections[i].owned = EINA_FALSE;
+	}
+}
+
+static void _reply_begin(msgpack_packer *const pk, const uint32_t req_id)
+{
+	msgpack_pack_array(pk, 4);
+	msgpack_pack_int(pk, 1);
+	msgpack_pack_uint32(pk, req_id);
+}
+
+static void _reply_error(struct nvim *const nvim, const uint32_t req_id, const char *const error)
+{
+	msgpack_packer *const pk = &nvim->rpc.packer;
+	const size_t len = strlen(error);
+
+	_reply_begin(pk, req_id);
+	msgpack_pack_str(pk, len);
+	msgpack_pack_str_body(pk, error, len);
+	msgpack_pack_nil(pk);
+	nvim_flush(nvim);
+}
+
+static void _reply_lines(struct nvim *const nvim, const uint32_t req_id, const char *const text,
+			 size_t size, const char *regtype)
+{
+	msgpack_packer *const pk = &nvim->rpc.packer;
+
+	/* A linewise selection ends with a newline, that is not a line. When
+	 * neovim did not set the selection, this is the only hint we have */
+	const Eina_Bool linewise = (size != 0u) && (text[size - 1u] == '\n');
+	if (!regtype)
+		regtype = (linewise) ? "V" : "v";
+	if (linewise && (regtype[0] == 'V'))
+		size--;
+
+	unsigned int lines = 1u;
+	for (size_t i = 0u; i < size; i++)
+		lines += (text[i] == '\n');
+
+	/* The result is [lines, regtype] */
+	_reply_begin(pk, req_id);
+	msgpack_pack_nil(pk);
+	msgpack_pack_array(pk, 2);
+	msgpack_pack_array(pk, lines);
+	const char *line = text;
+	const char *const end = text + size;
+	for (unsigned int i = 0u; i < lines; i++) {
+		const char *eol = memchr(line, '\n', (size_t)(end - line));
+		if (!eol)
+			eol = end;
+		msgpack_pack_str(pk, (size_t)(eol - line));
+		msgpack_pack_str_body(pk, line, (size_t)(eol - line));
+		line = eol + 1;
+	}
+	const size_t regtype_len = strlen(regtype);
+	msgpack_pack_str(pk, regtype_len);
+	msgpack_pack_str_body(pk, regtype, regtype_len);
+	nvim_flush(nvim);
+}
+
+static void _read_free(struct read *const read)
+{
+	if (read->timer)
+		ecore_timer_del(read->timer);
+	_reads = eina_list_remove(_reads, read);
+	free(read);
+}
+
+static void _read_end(struct read *const read, const char *const text, const size_t size)
+{
+	struct nvim *const nvim = read->nvim;
+
+	read->nvim = NULL;
+	nvim->clipboard->read = NULL;
+	if (read->timer) {
+		ecore_timer_del(read->timer);
+		read->timer = NULL;
+	}
+	_reply_lines(nvim, read->req_id, text, size, NULL);
+}
+
+static Eina_Bool _read_cb(void *const data, Evas_Object *const obj EINA_UNUSED,
+			  Elm_Selection_Data *const ev)
+{
+	struct read *const read = data;
+
+	/* The read may have timed out already, or its nvim be gone */
+	if (read->nvim) {
+		/* The text may or may not be NUL-terminated */
+		const char *const text = ev->data;
+		_read_end(read, text, (text) ? strnlen(text, ev->len) : 0u);
+	}
+	_read_free(read);
+	return EINA_TRUE;
+}
+
+static Eina_Bool _read_timeout_cb(void *const data)
+{
+	struct read *const read = data;
+
+	WRN("The selection could not be read in time. It is considered empty");
+	read->timer = NULL;
+	_read_end(read, "", 0u);
+	return ECORE_CALLBACK_CANCEL;
+}
+
+static Eina_Bool _clipboard_get_cb(struct nvim *const nvim, const msgpack_object_array *const args,
+				   msgpack_packer *const pk EINA_UNUSED, const uint32_t req_id)
+{
+	/* We expect: [register] */
+	const int id = (args->size == 1u) ? _selection_id_get(&args->ptr[0]) : -1;
+	struct clipboard *const clipboard = _clipboard_get(nvim);
+	if (EINA_UNLIKELY((id < 0) || (!clipboard) || (clipboard->read))) {
+		_reply_error(nvim, req_id, "cannot read this register");
+		return EINA_FALSE;
+	}
+
+	/* Give back what neovim yanked, as long as nobody else replaced it */
+	const struct selection *const sel = &(clipboard->selections[id]);
+	if (sel->owned) {
+		_reply_lines(nvim, req_id, eina_strbuf_string_get(sel->text),
+			     eina_strbuf_length_get(sel->text), sel->regtype);
+		return EINA_TRUE;
+	}
+
+	/* The selection is read asynchronously. We answer in _read_cb() */
+	struct read *const read = calloc(1, sizeof(struct read));
+	if (EINA_UNLIKELY(!read)) {
+		CRI("Failed to allocate memory");
+		_reply_error(nvim, req_id, "cannot read this register");
+		return EINA_FALSE;
+	}
+	read->nvim = nvim;
+	read->req_id = req_id;
+	read->timer = ecore_timer_add(CLIPBOARD_TIMEOUT, &_read_timeout_cb, read);
+	clipboard->read = read;
+	_reads = eina_list_append(_reads, read);
+
+	const Eina_Bool ok = elm_cnp_selection_get(nvim->gui.win, _sel_types[id],
+						   ELM_SEL_FORMAT_TEXT, &_read_cb, read);
+	if (EINA_UNLIKELY(!ok)) {
+		ERR("Failed to request the selection");
+		_read_end(read, "", 0u);
+		_read_free(read);
+	}
+	return EINA_TRUE;
+}
+
+Eina_Bool clipboard_set(struct nvim *const nvim, const msgpack_object_array *const params)
+{
+	/* We expect: [register, lines, regtype] */
+	if (EINA_UNLIKELY(params->size != 3u)) {
+		ERR("Three parameters are expected. Got %" PRIu32, params->size);
+		return EINA_FALSE;
+	}
+	const int id = _selection_id_get(&params->ptr[0]);
+	const msgpack_object_array *const lines =
+		MPACK_ARRAY_EXTRACT(&params->ptr[1], return EINA_FALSE);
+	Eina_Stringshare *const regtype = MPACK_STRING_EXTRACT(&params->ptr[2], return EINA_FALSE);
+	struct clipboard *const clipboard = _clipboard_get(nvim);
+	if (EINA_UNLIKELY((id < 0) || (!clipboard)))
+		goto fail;
+
+	/* Until the selection is set again, its text is not the one kept here */
+	struct selection *const sel = &(clipboard->selections[id]);
+	sel->owned = EINA_FALSE;
+	if (!sel->text) {
+		sel->text = eina_strbuf_new();
+		if (EINA_UNLIKELY(!sel->text)) {
+			CRI("Failed to create string buffer");
+			goto fail;
+		}
+	} else
+		eina_strbuf_reset(sel->text);
+
+	/* The selection holds text. A linewise selection ends with a newline */
+	for (uint32_t i = 0u; i < lines->size; i++) {
+		const msgpack_object_str *const line =
+			MPACK_STRING_OBJ_EXTRACT(&lines->ptr[i], goto fail);
+		if (i != 0u)
+			eina_strbuf_append_char(sel->text, '\n');
+		eina_strbuf_append_length(sel->text, line->ptr, line->size);
+	}
+	if (regtype[0] == 'V')
+		eina_strbuf_append_char(sel->text, '\n');
+	eina_stringshare_replace(&sel->regtype, regtype);
+	eina_stringshare_del(regtype);
+
+	Evas_Object *const win = nvim->gui.win;
+	const Elm_Sel_Type type = _sel_types[id];
+	sel->owned = elm_cnp_selection_set(win, type, ELM_SEL_FORMAT_TEXT,
+					   eina_strbuf_string_get(sel->text),
+					   eina_strbuf_length_get(sel->text));
+	if (EINA_UNLIKELY(!sel->owned)) {
+		ERR("Failed to set the selection");
+		return EINA_FALSE;
+	}
+	elm_cnp_selection_loss_callback_set(win, type, &_selection_loss_cb, nvim);
+	return EINA_TRUE;
+
+fail:
+	eina_stringshare_del(regtype);
+	return EINA_FALSE;
+}
+
+void clipboard_release(struct nvim *const nvim)
+{
+	struct clipboard *const clipboard = nvim->clipboard;
+	if (!clipboard)
+		return;
+
+	/* A pending read is answered now. Its callback will find it detached */
+	if (clipboard->read)
+		_read_end(clipboard->read, "", 0u);
+	for (unsigned int i = 0u; i < SELECTION_LAST; i++) {
+		struct selection *const sel = &(clipboard->selections[i]);
+		if (sel->text) {
+			if (nvim->gui.win)
+				elm_cnp_selection_loss_callback_set(nvim->gui.win, _sel_types[i],
+								    NULL, NULL);
+			eina_strbuf_free(sel->text);
+		}
+		eina_stringshare_del(sel->regtype);
+	}
+	free(clipboard);
+	nvim->clipboard = NULL;
+}
+
+Eina_Bool clipboard_init(void)
+{
+	return nvim_request_add("clipboard_get", &_clipboard_get_cb);
+}
+
+void clipboard_shutdown(void)
+{
+	struct read *read;
+	EINA_LIST_FREE(_reads, read)
+	{
+		if (read->timer)
+			ecore_timer_del(read->timer);
+		free(read);
+	}
+	nvim_request_del("clipboard_get");
+}
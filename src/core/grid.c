@@ -0,0 +1,642 @@
+/* This file is part of Eovim, which is under the MIT License ****************/
+
+#include "eovim/grid.h"
+#include "eovim/log.h"
+#include "eovim/mem.h"
+
+#include <assert.h>
+
+static struct grid_style *_grid_style_new(void)
+{
+	struct grid_style *const style = calloc(1, sizeof(struct grid_style));
+	if (EINA_LIKELY(style != NULL))
+		mem_alloc_account(MEM_POOL_STYLES, sizeof(struct grid_style));
+	return style;
+}
+
+static void _grid_style_free(struct grid_style *const style)
+{
+	mem_free_account(MEM_POOL_STYLES, sizeof(struct grid_style));
+	free(style);
+}
+
+static size_t _hl_group_bytes(const char *const name)
+{
+	/* The hash table copies the key, and points to the style */
+	return strlen(name) + 1u + sizeof(struct grid_style *);
+}
+
+static Eina_Bool _hl_group_release_cb(const Eina_Hash *const hash EINA_UNUSED,
+				      const void *const key, void *const data EINA_UNUSED,
+				      void *const fdata EINA_UNUSED)
+{
+	mem_free_account(MEM_POOL_HL_GROUPS, _hl_group_bytes(key));
+	return EINA_TRUE;
+}
+
+static size_t _grid_bytes(const unsigned int cols, const unsigned int rows)
+{
+	/* The cells, the rows, their dirty flags, and the row saved by the
+	 * predictions */
+	return (size_t)rows * ((size_t)cols * sizeof(struct grid_cell) +
+			       sizeof(struct grid_cell *) + sizeof(Eina_Bool)) +
+	       (size_t)cols * sizeof(struct grid_cell);
+}
+
+static void _cells_blank(struct grid_cell *const cells, const size_t count)
+{
+	for (size_t i = 0u; i < count; i++) {
+		struct grid_cell *const c = &cells[i];
+		c->utf8[0] = ' ';
+		c->bytes = 1;
+		c->style_id = 0;
+	}
+}
+
+struct grid *grid_new(void)
+{
+	struct grid *const grid = calloc(1, sizeof(struct grid));
+	if (EINA_UNLIKELY(!grid)) {
+		CRI("Failed to allocate memory");
+		goto fail;
+	}
+
+	grid->styles = eina_hash_int64_new(EINA_FREE_CB(_grid_style_free));
+	if (EINA_UNLIKELY(!grid->styles)) {
+		CRI("Failed to create hash table");
+		goto free_grid;
+	}
+
+	/* Values are owned by the styles table */
+	grid->hl_groups = eina_hash_string_superfast_new(NULL);
+	if (EINA_UNLIKELY(!grid->hl_groups)) {
+		CRI("Failed to create hash table");
+		goto free_styles;
+	}
+
+	return grid;
+
+free_styles:
+	eina_hash_free(grid->styles);
+free_grid:
+	free(grid);
+fail:
+	return NULL;
+}
+
+void grid_free(struct grid *const grid)
+{
+	if (grid) {
+		eina_hash_foreach(grid->hl_groups, &_hl_group_release_cb, NULL);
+		eina_hash_free(grid->hl_groups);
+		eina_hash_free(grid->styles);
+		if (grid->cells) {
+			free(grid->cells[0]);
+			free(grid->cells);
+		}
+		free(grid->dirty_rows);
+		free(grid->predictions.saved_row);
+		mem_free_account(MEM_POOL_GRID, _grid_bytes(grid->cols, grid->rows));
+		free(grid);
+	}
+}
+
+void grid_backend_set(struct grid *const grid, const struct grid_backend *const backend,
+		      void *const data)
+{
+	grid->backend = backend;
+	grid->backend_data = data;
+}
+
+static void _cell_insert(struct grid *const grid, const struct grid_prediction *const item)
+{
+	/* Typing in insert mode pushes the rest of the row to the right */
+	struct grid_cell *const cells_row = grid->cells[item->row];
+	memmove(&cells_row[item->col + 1u], &cells_row[item->col],
+		sizeof(struct grid_cell) * (grid->cols - item->col - 1u));
+	cells_row[item->col] = item->cell;
+	grid->dirty_rows[item->row] = EINA_TRUE;
+}
+
+static void _predictions_apply(struct grid *const grid)
+{
+	const struct grid_prediction *const first = &grid->predictions.items[0];
+	const unsigned int count = grid->predictions.count;
+
+	memcpy(grid->predictions.saved_row, grid->cells[first->row],
+	       sizeof(struct grid_cell) * grid->cols);
+	for (unsigned int i = 0u; i < count; i++)
+		_cell_insert(grid, &grid->predictions.items[i]);
+	grid->cursor.x = grid->predictions.items[count - 1u].col + 1u;
+	grid->predictions.applied = EINA_TRUE;
+}
+
+static void _predictions_rollback(struct grid *const grid)
+{
+	if (!grid->predictions.applied)
+		return;
+
+	/* The first prediction was made where neovim had put the cursor */
+	const struct grid_prediction *const first = &grid->predictions.items[0];
+	memcpy(grid->cells[first->row], grid->predictions.saved_row,
+	       sizeof(struct grid_cell) * grid->cols);
+	grid->dirty_rows[first->row] = EINA_TRUE;
+	grid->cursor.x = first->col;
+	grid->cursor.y = first->row;
+	grid->predictions.applied = EINA_FALSE;
+}
+
+void grid_resize(struct grid *const grid, const unsigned int cols, const unsigned int rows)
+{
+	EINA_SAFETY_ON_TRUE_RETURN((cols == 0) || (rows == 0));
+
+	/* Prevent useless resize */
+	if ((grid->cols == cols) && (grid->rows == rows))
+		return;
+
+	/* All the cells are blanked anyway */
+	grid->predictions.count = 0u;
+	grid->predictions.applied = EINA_FALSE;
+
+	/* We maintain the grid of cells as an Iliffe vector. Make sure we
+	 * properly resize it without losing allocated memory */
+	mem_free_account(MEM_POOL_GRID, _grid_bytes(grid->cols, grid->rows));
+	if (grid->cells) {
+		free(grid->cells[0]);
+		grid->cells[0] = NULL;
+	}
+	struct grid_cell **const cells = realloc(grid->cells, rows * sizeof(struct grid_cell *));
+	if (EINA_UNLIKELY(!cells))
+		goto fail;
+	grid->cells = cells;
+	cells[0] = malloc(rows * cols * sizeof(struct grid_cell));
+	if (EINA_UNLIKELY(!cells[0]))
+		goto fail;
+	Eina_Bool *const dirty_rows = realloc(grid->dirty_rows, rows * sizeof(Eina_Bool));
+	if (EINA_UNLIKELY(!dirty_rows))
+		goto fail;
+	grid->dirty_rows = dirty_rows;
+	struct grid_cell *const saved_row =
+		realloc(grid->predictions.saved_row, cols * sizeof(struct grid_cell));
+	if (EINA_UNLIKELY(!saved_row))
+		goto fail;
+	grid->predictions.saved_row = saved_row;
+	for (unsigned int i = 1; i < rows; i++)
+		cells[i] = cells[i - 1] + cols;
+
+	/* Every cell contains a single whitespace. All rows must be drawn */
+	_cells_blank(cells[0], (size_t)rows * cols);
+	memset(grid->dirty_rows, 0xff, sizeof(Eina_Bool) * rows);
+	grid->cols = cols;
+	grid->rows = rows;
+	mem_alloc_account(MEM_POOL_GRID, _grid_bytes(cols, rows));
+
+	if (grid->cursor.y >= rows)
+		grid->cursor.y = rows - 1u;
+	if (grid->cursor.x >= cols)
+		grid->cursor.x = cols - 1u;
+
+	grid->batch_open = EINA_TRUE;
+	if (grid->backend && grid->backend->resized)
+		grid->backend->resized(grid->backend_data, cols, rows);
+	return;
+
+fail:
+	/* Leave the grid empty, rather than in an inconsistent state */
+	CRI("Failed to allocate memory for a %ux%u grid", cols, rows);
+	if (grid->cells) {
+		free(grid->cells[0]);
+		free(grid->cells);
+		grid->cells = NULL;
+	}
+	free(grid->dirty_rows);
+	grid->dirty_rows = NULL;
+	free(grid->predictions.saved_row);
+	grid->predictions.saved_row = NULL;
+	grid->cols = grid->rows = 0u;
+}
+
+void grid_clear(struct grid *const grid)
+{
+	EINA_SAFETY_ON_FALSE_RETURN(grid->cols != 0 && grid->rows != 0);
+
+	grid->predictions.count = 0u;
+	grid->predictions.applied = EINA_FALSE;
+	_cells_blank(grid->cells[0], (size_t)grid->rows * grid->cols);
+	memset(grid->dirty_rows, 0xff, sizeof(Eina_Bool) * grid->rows);
+	grid->batch_open = EINA_TRUE;
+
+	if (grid->backend && grid->backend->cleared)
+		grid->backend->cleared(grid->backend_data);
+}
+
+void grid_line_edit(struct grid *const grid, const unsigned int row, const unsigned int col,
+		    const char *const text, const size_t text_len, const t_int style_id,
+		    const size_t repeat)
+{
+	EINA_SAFETY_ON_FALSE_RETURN(row < grid->rows);
+	EINA_SAFETY_ON_FALSE_RETURN((size_t)col + repeat <= grid->cols);
+	assert(text_len <= sizeof(grid->cells[0][0].utf8));
+
+	_predictions_rollback(grid);
+	grid->batch_open = EINA_TRUE;
+	struct grid_cell *const cells_row = grid->cells[row];
+	for (size_t i = 0; i < repeat; i++) {
+		struct grid_cell *const c = &cells_row[col + i];
+		memcpy(c->utf8, text, text_len);
+		c->bytes = (uint32_t)text_len;
+		c->style_id = (uint32_t)style_id;
+	}
+	grid->dirty_rows[row] = EINA_TRUE;
+}
+
+void grid_scroll(struct grid *const grid, const int top, const int bot, const int left,
+		 const int right, const int rows)
+{
+	EINA_SAFETY_ON_FALSE_RETURN(right > left);
+	EINA_SAFETY_ON_FALSE_RETURN(top >= 0 && bot >= 0 && left >= 0);
+	EINA_SAFETY_ON_FALSE_RETURN((unsigned int)right <= grid->cols);
+	EINA_SAFETY_ON_FALSE_RETURN((unsigned int)bot <= grid->rows);
+
+	_predictions_rollback(grid);
+	grid->batch_open = EINA_TRUE;
+	int start_line, end_line, step;
+	if (rows > 0) {
+		/* Here, we scroll text UPWARDS. Line N-1 is replaced by line N.
+		 *
+		 *
+		 * top
+		 *   '>+------------------+     +------------------+
+		 *     | Line 0           |  ,> | Line 1           |
+		 *     +------------------+ /   +------------------+
+		 * (1) | Line 1           |' ,> | Line 2           |
+		 *     +------------------+ /   +------------------+
+		 * (2) | Line 2           |'    | xxxxxx           |
+		 *  ,> +------------------+     +------------------+
+		 * bot
+		 *
+		 * So we start at top+|rows|, because top replaces nothing.
+		 *     top+rows will overwrite top.
+		 *     top+rows+1 will overwrite top+rows+1
+		 *     etc.
+		 *
+		 * One bot is reached (exclusive), we are done.
+		 */
+		start_line = top + rows;
+		end_line = bot;
+		step = +1;
+	} else {
+		/* Here, we scroll text DOWNWARDS. Line N+1 is replaced by line N.
+		 *
+		 *     +------------------+     +------------------+
+		 * (2) | Line 0           |,    | xxxxxx           |
+		 *     +------------------+ \   +------------------+
+		 * (1) | Line 1           |, '> | Line 0           |
+		 *     +------------------+ \   +------------------+
+		 *     | Line 2           |  '> | Line 1           |
+		 *     +------------------+     +------------------+
+		 *
+		 * We start at bot-1-|rows|
+		 */
+		assert(rows < 0); /* <--- Frienly reminder */
+		start_line = bot - 1 + rows;
+		end_line = top - 1; /* Make the range exclusive */
+		step = -1;
+	}
+
+	for (int from_line = start_line; from_line != end_line; from_line += step) {
+		const int to_line = from_line - rows;
+		if (((unsigned int)to_line >= grid->rows) ||
+		    ((unsigned int)from_line >= grid->rows))
+			continue;
+
+		const struct grid_cell *const source_row = grid->cells[from_line];
+		struct grid_cell *const target_row = grid->cells[to_line];
+
+		const size_t len = sizeof(struct grid_cell) * (size_t)(right - left);
+		memcpy(&target_row[left], &source_row[left], len);
+
+		grid->dirty_rows[to_line] = EINA_TRUE;
+	}
+}
+
+void grid_cursor_goto(struct grid *const grid, const unsigned int to_x, const unsigned int to_y)
+{
+	EINA_SAFETY_ON_FALSE_RETURN(to_y < grid->rows);
+	EINA_SAFETY_ON_FALSE_RETURN(grid->cols != 0 && grid->rows != 0);
+
+	_predictions_rollback(grid);
+	grid->batch_open = EINA_TRUE;
+	grid->cursor.x = to_x;
+	grid->cursor.y = to_y;
+}
+
+unsigned int grid_flush(struct grid *const grid)
+{
+	const struct grid_backend *const backend = grid->backend;
+	unsigned int drawn = 0u;
+
+	for (unsigned int i = 0u; i < grid->rows; i++) {
+		if (!grid->dirty_rows[i])
+			continue;
+		if (backend && backend->row_draw)
+			backend->row_draw(grid->backend_data, i, grid->cells[i], grid->cols);
+		drawn++;
+	}
+	if (grid->rows)
+		memset(grid->dirty_rows, 0, sizeof(Eina_Bool) * grid->rows);
+	grid->batch_open = EINA_FALSE;
+	return drawn;
+}
+
+void grid_row_flush(struct grid *const grid, const unsigned int row)
+{
+	const struct grid_backend *const backend = grid->backend;
+
+	EINA_SAFETY_ON_FALSE_RETURN(row < grid->rows);
+	if (!grid->dirty_rows[row])
+		return;
+	if (backend && backend->row_draw)
+		backend->row_draw(grid->backend_data, row, grid->cells[row], grid->cols);
+	grid->dirty_rows[row] = EINA_FALSE;
+}
+
+Eina_Bool grid_predict(struct grid *const grid, const char *const utf8, const size_t bytes)
+{
+	const unsigned int x = grid->cursor.x;
+	const unsigned int y = grid->cursor.y;
+	const unsigned int count = grid->predictions.count;
+
+	/* Between the first change of a batch and its flush, the cells are
+	 * neither the ones neovim had drawn nor the ones it will draw (the batch
+	 * may span several reads), and the predictions are not reconciled yet */
+	if (grid->batch_open)
+		return EINA_FALSE;
+	if ((count == GRID_PREDICTIONS_MAX) || (bytes == 0u) ||
+	    (bytes > sizeof(grid->cells[0][0].utf8)))
+		return EINA_FALSE;
+	/* On the last column, neovim would wrap or scroll */
+	if ((y >= grid->rows) || (x + 1u >= grid->cols))
+		return EINA_FALSE;
+
+	struct grid_prediction *const item = &grid->predictions.items[count];
+	item->row = y;
+	item->col = x;
+	memcpy(item->cell.utf8, utf8, bytes);
+	item->cell.bytes = (uint32_t)bytes;
+	/* Typed text most likely has the highlight of the text it follows */
+	item->cell.style_id = grid->cells[y][(x > 0u) ? x - 1u : x].style_id;
+
+	if (count == 0u)
+		memcpy(grid->predictions.saved_row, grid->cells[y],
+		       sizeof(struct grid_cell) * grid->cols);
+	grid->predictions.count++;
+	grid->predictions.applied = EINA_TRUE;
+	_cell_insert(grid, item);
+	grid->cursor.x = x + 1u;
+	return EINA_TRUE;
+}
+
+void grid_predictions_reconcile(struct grid *const grid)
+{
+	/* Nothing changed since the predictions were drawn */
+	if (grid->predictions.applied || (grid->predictions.count == 0u))
+		return;
+
+	unsigned int done = 0u;
+	for (; done < grid->predictions.count; done++) {
+		const struct grid_prediction *const item = &grid->predictions.items[done];
+
+		/* Neovim did not process this character yet, nor the next ones */
+		if ((grid->cursor.x == item->col) && (grid->cursor.y == item->row))
+			break;
+
+		/* Neovim did not draw the character where it was predicted (e.g.
+		 * it was a mapping). What neovim drew stays */
+		const struct grid_cell *const c = &grid->cells[item->row][item->col];
+		if ((c->bytes != item->cell.bytes) || memcmp(c->utf8, item->cell.utf8, c->bytes)) {
+			grid->predictions.count = 0u;
+			return;
+		}
+	}
+
+	grid->predictions.count -= done;
+	if (grid->predictions.count != 0u) {
+		memmove(grid->predictions.items, &grid->predictions.items[done],
+			sizeof(struct grid_prediction) * grid->predictions.count);
+		_predictions_apply(grid);
+	}
+}
+
+void grid_predictions_drop(struct grid *const grid)
+{
+	_predictions_rollback(grid);
+	grid->predictions.count = 0u;
+}
+
+struct grid_style *grid_style_get(struct grid *const grid, const t_int style_id)
+{
+	struct grid_style *style = eina_hash_find(grid->styles, &style_id);
+	if (style == NULL) {
+		style = _grid_style_new();
+		if (EINA_UNLIKELY(!style)) {
+			CRI("Failed to allocate memory");
+			return NULL;
+		}
+		const Eina_Bool added = eina_hash_add(grid->styles, &style_id, style);
+		if (EINA_UNLIKELY(!added)) {
+			ERR("Failed to add style to hash table");
+			_grid_style_free(style);
+			return NULL;
+		}
+	}
+	return style;
+}
+
+const struct grid_style *grid_style_find(const struct grid *const grid, const t_int style_id)
+{
+	return eina_hash_find(grid->styles, &style_id);
+}
+
+void grid_styles_changed(struct grid *const grid)
+{
+	if (grid->backend && grid->backend->styles_changed)
+		grid->backend->styles_changed(grid->backend_data);
+}
+
+void grid_default_colors_set(struct grid *const grid, const union color fg, const union color bg,
+			     const union color sp)
+{
+	const Eina_Bool changed = (grid->default_fg.value != fg.value) ||
+				  (grid->default_bg.value != bg.value) ||
+				  (grid->default_sp.value != sp.value);
+	if (changed) {
+		grid->default_fg = fg;
+		grid->default_bg = bg;
+		grid->default_sp = sp;
+		grid_styles_changed(grid);
+	}
+}
+
+Eina_Bool grid_hl_group_set(struct grid *const grid, const char *const name, const t_int style_id)
+{
+	const struct grid_style *const style = grid_style_get(grid, style_id);
+	if (EINA_UNLIKELY(!style)) {
+		ERR("Failed find style with id %" PRIi64, style_id);
+		return EINA_FALSE;
+	}
+
+	/* Only new groups take more memory. Existing ones are just updated */
+	if (eina_hash_find(grid->hl_groups, name))
+		return eina_hash_modify(grid->hl_groups, name, style) != NULL;
+	if (EINA_UNLIKELY(!eina_hash_add(grid->hl_groups, name, style))) {
+		ERR("Failed to register highlight group '%s'", name);
+		return EINA_FALSE;
+	}
+	mem_alloc_account(MEM_POOL_HL_GROUPS, _hl_group_bytes(name));
+	return EINA_TRUE;
+}
+
+/* Highlight attributes are packed as a set of flags */
+enum {
+	SNAPSHOT_STYLE_REVERSE = (1 << 0),
+	SNAPSHOT_STYLE_ITALIC = (1 << 1),
+	SNAPSHOT_STYLE_BOLD = (1 << 2),
+	SNAPSHOT_STYLE_UNDERLINE = (1 << 3),
+	SNAPSHOT_STYLE_UNDERCURL = (1 << 4),
+	SNAPSHOT_STYLE_STRIKETHROUGH = (1 << 5),
+};
+
+static Eina_Bool _style_pack_cb(const Eina_Hash *const hash EINA_UNUSED, const void *const key,
+				void *const data, void *const fdata)
+{
+	const struct grid_style *const style = data;
+	msgpack_packer *const pk = fdata;
+	const unsigned int flags = (style->reverse ? SNAPSHOT_STYLE_REVERSE : 0) |
+				   (style->italic ? SNAPSHOT_STYLE_ITALIC : 0) |
+				   (style->bold ? SNAPSHOT_STYLE_BOLD : 0) |
+				   (style->underline ? SNAPSHOT_STYLE_UNDERLINE : 0) |
+				   (style->undercurl ? SNAPSHOT_STYLE_UNDERCURL : 0) |
+				   (style->strikethrough ? SNAPSHOT_STYLE_STRIKETHROUGH : 0);
+
+	msgpack_pack_array(pk, 5);
+	msgpack_pack_int64(pk, *((const t_int *)key));
+	msgpack_pack_uint32(pk, style->fg_color.value);
+	msgpack_pack_uint32(pk, style->bg_color.value);
+	msgpack_pack_uint32(pk, style->sp_color.value);
+	msgpack_pack_uint32(pk, flags);
+	return EINA_TRUE;
+}
+
+void grid_snapshot_pack(const struct grid *const grid, msgpack_packer *const pk)
+{
+	/* [cols, rows, fg, bg, sp, [[id, fg, bg, sp, flags]...], [text, id, ...]] */
+	msgpack_pack_array(pk, 7);
+	msgpack_pack_uint32(pk, grid->cols);
+	msgpack_pack_uint32(pk, grid->rows);
+	msgpack_pack_uint32(pk, grid->default_fg.value);
+	msgpack_pack_uint32(pk, grid->default_bg.value);
+	msgpack_pack_uint32(pk, grid->default_sp.value);
+
+	msgpack_pack_array(pk, (size_t)eina_hash_population(grid->styles));
+	eina_hash_foreach(grid->styles, &_style_pack_cb, pk);
+
+	msgpack_pack_array(pk, (size_t)grid->cols * grid->rows * 2u);
+	for (unsigned int row = 0u; row < grid->rows; row++) {
+		for (unsigned int col = 0u; col < grid->cols; col++) {
+			const struct grid_cell *const c = &grid->cells[row][col];
+			msgpack_pack_str_with_body(pk, c->utf8, c->bytes);
+			msgpack_pack_uint32(pk, c->style_id);
+		}
+	}
+}
+
+static Eina_Bool _snapshot_uints_are(const msgpack_object *const objs, const uint32_t count)
+{
+	for (uint32_t i = 0u; i < count; i++)
+		if ((objs[i].type != MSGPACK_OBJECT_POSITIVE_INTEGER) ||
+		    (objs[i].via.u64 > UINT32_MAX))
+			return EINA_FALSE;
+	return EINA_TRUE;
+}
+
+Eina_Bool grid_snapshot_load(struct grid *const grid, const msgpack_object *const obj)
+{
+	/* Everything is checked before the grid is modified, so a corrupted
+	 * snapshot leaves the grid untouched */
+	if (EINA_UNLIKELY((obj->type != MSGPACK_OBJECT_ARRAY) || (obj->via.array.size != 7u)))
+		goto invalid;
+	const msgpack_object *const args = obj->via.array.ptr;
+	if (EINA_UNLIKELY(!_snapshot_uints_are(args, 5u) ||
+			  (args[5].type != MSGPACK_OBJECT_ARRAY) ||
+			  (args[6].type != MSGPACK_OBJECT_ARRAY)))
+		goto invalid;
+
+	const unsigned int cols = (unsigned int)args[0].via.u64;
+	const unsigned int rows = (unsigned int)args[1].via.u64;
+	if (EINA_UNLIKELY((cols == 0u) || (rows == 0u) || (cols > UINT16_MAX) ||
+			  (rows > UINT16_MAX)))
+		goto invalid;
+
+	const msgpack_object_array *const styles = &(args[5].via.array);
+	for (uint32_t i = 0u; i < styles->size; i++) {
+		const msgpack_object *const s = &(styles->ptr[i]);
+		if (EINA_UNLIKELY((s->type != MSGPACK_OBJECT_ARRAY) || (s->via.array.size != 5u) ||
+				  !_snapshot_uints_are(s->via.array.ptr, 5u)))
+			goto invalid;
+	}
+
+	const msgpack_object_array *const cells = &(args[6].via.array);
+	if (EINA_UNLIKELY(cells->size != (size_t)cols * rows * 2u))
+		goto invalid;
+	for (uint32_t i = 0u; i < cells->size; i += 2u) {
+		if (EINA_UNLIKELY((cells->ptr[i].type != MSGPACK_OBJECT_STR) ||
+				  (cells->ptr[i].via.str.size > sizeof(grid->cells[0][0].utf8)) ||
+				  !_snapshot_uints_are(&(cells->ptr[i + 1u]), 1u)))
+			goto invalid;
+	}
+
+	grid_resize(grid, cols, rows);
+	if (EINA_UNLIKELY((grid->cols != cols) || (grid->rows != rows)))
+		return EINA_FALSE;
+
+	for (uint32_t i = 0u; i < styles->size; i++) {
+		const msgpack_object *const s = styles->ptr[i].via.array.ptr;
+		struct grid_style *const style = grid_style_get(grid, (t_int)s[0].via.u64);
+		if (EINA_UNLIKELY(!style))
+			continue;
+		const uint64_t flags = s[4].via.u64;
+		style->fg_color.value = (uint32_t)s[1].via.u64;
+		style->bg_color.value = (uint32_t)s[2].via.u64;
+		style->sp_color.value = (uint32_t)s[3].via.u64;
+		style->reverse = !!(flags & SNAPSHOT_STYLE_REVERSE);
+		style->italic = !!(flags & SNAPSHOT_STYLE_ITALIC);
+		style->bold = !!(flags & SNAPSHOT_STYLE_BOLD);
+		style->underline = !!(flags & SNAPSHOT_STYLE_UNDERLINE);
+		style->undercurl = !!(flags & SNAPSHOT_STYLE_UNDERCURL);
+		style->strikethrough = !!(flags & SNAPSHOT_STYLE_STRIKETHROUGH);
+	}
+
+	for (unsigned int row = 0u; row < rows; row++) {
+		for (unsigned int col = 0u; col < cols; col++) {
+			const size_t index = ((size_t)row * cols + col) * 2u;
+			const msgpack_object *const o = &(cells->ptr[index]);
+			struct grid_cell *const c = &grid->cells[row][col];
+			memcpy(c->utf8, o[0].via.str.ptr, o[0].via.str.size);
+			c->bytes = o[0].via.str.size;
+			c->style_id = (uint32_t)o[1].via.u64;
+		}
+	}
+	memset(grid->dirty_rows, 0xff, sizeof(Eina_Bool) * rows);
+
+	const union color fg = { .value = (uint32_t)args[2].via.u64 };
+	const union color bg = { .value = (uint32_t)args[3].via.u64 };
+	const union color sp = { .value = (uint32_t)args[4].via.u64 };
+	grid_default_colors_set(grid, fg, bg, sp);
+	grid_styles_changed(grid);
+	return EINA_TRUE;
+
+invalid:
+	ERR("Invalid grid snapshot");
+	return EINA_FALSE;
+}
@@ -0,0 +1,7 @@
+/* This file is part of Eovim, which is under the MIT License ****************/
+
+#include "eovim/log.h"
+
+/* The log domain shall be registered by the program that links with eovim's
+ * core. See elm_main() */
+int _eovim_log_domain = -1;
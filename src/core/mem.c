@@ -0,0 +1,94 @@
+/* This file is part of Eovim, which is under the MIT License ****************/
+
+#include "eovim/mem.h"
+
+#include <time.h>
+
+static const char *const _pool_names[__MEM_POOL_LAST] = {
+	[MEM_POOL_GRID] = "grid",
+	[MEM_POOL_TEXTBLOCK] = "textblock",
+	[MEM_POOL_STYLES] = "styles",
+	[MEM_POOL_HL_GROUPS] = "hl_groups",
+	[MEM_POOL_KIND_STYLES] = "kind_styles",
+	[MEM_POOL_RPC] = "rpc",
+	[MEM_POOL_REQUESTS] = "requests",
+	[MEM_POOL_COMPLETION] = "completion",
+	[MEM_POOL_WILDMENU] = "wildmenu",
+};
+
+static struct mem_stats _stats[__MEM_POOL_LAST];
+
+/* Time of the first accounting, in seconds. Used to compute rates */
+static double _origin = 0.0;
+
+static double _now(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+static void _grow(struct mem_stats *const stats, const size_t bytes)
+{
+	if (EINA_UNLIKELY(_origin <= 0.0))
+		_origin = _now();
+
+	stats->current += bytes;
+	stats->allocations++;
+	if (stats->current > stats->peak)
+		stats->peak = stats->current;
+}
+
+void mem_alloc_account(const enum mem_pool pool, const size_t bytes)
+{
+	EINA_SAFETY_ON_FALSE_RETURN(pool < __MEM_POOL_LAST);
+	_grow(&_stats[pool], bytes);
+}
+
+void mem_free_account(const enum mem_pool pool, const size_t bytes)
+{
+	EINA_SAFETY_ON_FALSE_RETURN(pool < __MEM_POOL_LAST);
+	struct mem_stats *const stats = &_stats[pool];
+
+	/* Don't wrap around if a release was accounted twice */
+	stats->current = (bytes > stats->current) ? 0u : stats->current - bytes;
+}
+
+void mem_usage_update(const enum mem_pool pool, size_t *const owned, const size_t bytes)
+{
+	EINA_SAFETY_ON_FALSE_RETURN(pool < __MEM_POOL_LAST);
+	struct mem_stats *const stats = &_stats[pool];
+
+	if (bytes > *owned)
+		_grow(stats, bytes - *owned);
+	else
+		mem_free_account(pool, *owned - bytes);
+	*owned = bytes;
+}
+
+const struct mem_stats *mem_stats_get(const enum mem_pool pool)
+{
+	EINA_SAFETY_ON_FALSE_RETURN_VAL(pool < __MEM_POOL_LAST, NULL);
+	return &_stats[pool];
+}
+
+const char *mem_pool_name_get(const enum mem_pool pool)
+{
+	EINA_SAFETY_ON_FALSE_RETURN_VAL(pool < __MEM_POOL_LAST, NULL);
+	return _pool_names[pool];
+}
+
+void mem_report(void)
+{
+	const double elapsed = (_origin > 0.0) ? _now() - _origin : 0.0;
+
+	printf("%-12s %14s %14s %14s %12s\n", "Pool", "Current (B)", "Peak (B)", "Allocations",
+	       "Allocs/s");
+	for (unsigned int i = 0u; i < __MEM_POOL_LAST; i++) {
+		const struct mem_stats *const stats = &_stats[i];
+		printf("%-12s %14zu %14zu %14" PRIu64 " %12.1f\n", _pool_names[i], stats->current,
+		       stats->peak, stats->allocations,
+		       (elapsed > 0.0) ? (double)stats->allocations / elapsed : 0.0);
+	}
+	fflush(stdout);
+}
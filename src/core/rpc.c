@@ -0,0 +1,296 @@
+/* This file is part of Eovim, which is under the MIT License ****************/
+
+#include "eovim/rpc.h"
+#include "eovim/log.h"
+#include "eovim/mem.h"
+
+#include <time.h>
+
+/* Bytes received and not processed yet, past which rpc_data_dispatch() does
+ * not stop when its budget ran out: the backlog must not grow without bound */
+#define RPC_BACKLOG_MAX (4u * 1024u * 1024u)
+
+static void _rpc_mem_update(struct rpc *const rpc)
+{
+	/* The unpacker's buffer only grows, as does the send buffer. The zones
+	 * holding the unpacked objects are internal to msgpack, and short-lived */
+	const msgpack_unpacker *const unpacker = &rpc->unpacker;
+	mem_usage_update(MEM_POOL_RPC, &rpc->mem,
+			 unpacker->used + unpacker->free + rpc->sbuffer.alloc);
+}
+
+static inline size_t _backlog_get(const msgpack_unpacker *const unpacker)
+{
+	return unpacker->used - unpacker->off;
+}
+
+static double _now(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+static Eina_Stringshare *_stringshare_extract(const msgpack_object *obj)
+{
+	if (obj->type == MSGPACK_OBJECT_STR) {
+		const msgpack_object_str *const str = &(obj->via.str);
+		return eina_stringshare_add_length(str->ptr, str->size);
+	} else if (obj->type == MSGPACK_OBJECT_BIN) {
+		const msgpack_object_bin *const bin = &(obj->via.bin);
+		return eina_stringshare_add_length(bin->ptr, bin->size);
+	} else {
+		ERR("A string (or BIN string) was expected, but it is of type 0x%x", obj->type);
+		return NULL;
+	}
+}
+
+static Eina_Bool _handle_request(struct rpc *rpc, const msgpack_object_array *args)
+{
+	/* Retrieve the request identifier ****************************************/
+	if (EINA_UNLIKELY(args->ptr[1].type != MSGPACK_OBJECT_POSITIVE_INTEGER)) {
+		ERR("Second argument in request is expected to be an integer");
+		return EINA_FALSE;
+	}
+	const uint64_t long_req_id = args->ptr[1].via.u64;
+	if (EINA_UNLIKELY(long_req_id > UINT32_MAX)) {
+		ERR("Request ID '%" PRIu64 " is too big", long_req_id);
+		return EINA_FALSE;
+	}
+	const uint32_t req_id = (uint32_t)long_req_id;
+
+	/* Retrieve the request arguments *****************************************/
+	if (EINA_UNLIKELY(args->ptr[3].type != MSGPACK_OBJECT_ARRAY)) {
+		ERR("Fourth argument in request is expected to be an array");
+		return EINA_FALSE;
+	}
+	const msgpack_object_array *const req_args = &(args->ptr[3].via.array);
+
+	/* Retrieve the request name **********************************************/
+	if (EINA_UNLIKELY(args->ptr[2].type != MSGPACK_OBJECT_STR)) {
+		ERR("Third argument in request is expected to be a string");
+		return EINA_FALSE;
+	}
+	const msgpack_object_str *const str = &(args->ptr[2].via.str);
+	Eina_Stringshare *const request = eina_stringshare_add_length(str->ptr, str->size);
+	if (EINA_UNLIKELY(!request)) {
+		ERR("Failed to create stringshare");
+		return EINA_FALSE;
+	}
+
+	const Eina_Bool ok = rpc->handlers->request(rpc->data, req_id, request, req_args);
+	eina_stringshare_del(request);
+	return ok;
+}
+
+static Eina_Bool _handle_request_response(struct rpc *rpc, const msgpack_object_array *args)
+{
+	/* 2nd arg should be an integer */
+	if (EINA_UNLIKELY(args->ptr[1].type != MSGPACK_OBJECT_POSITIVE_INTEGER)) {
+		ERR("Second argument in response is expected to be an integer");
+		return EINA_FALSE;
+	}
+	const uint32_t req_id = (uint32_t)args->ptr[1].via.u64;
+	DBG("Received response to request %" PRIu32, req_id);
+
+	/* If 3rd arg is an array, this is an error message. The handler is
+	 * still called (without result), so the request can be discarded */
+	const msgpack_object_type err_type = args->ptr[2].type;
+	if (err_type == MSGPACK_OBJECT_ARRAY) {
+		const msgpack_object_array *const err_args = &(args->ptr[2].via.array);
+		if (EINA_UNLIKELY(err_args->size != 2)) {
+			ERR("Error response is supposed to have two arguments");
+			goto fail;
+		}
+		if (EINA_UNLIKELY(err_args->ptr[1].type != MSGPACK_OBJECT_STR)) {
+			ERR("Error response is supposed to contain a string");
+			goto fail;
+		}
+		const msgpack_object_str *const e = &(err_args->ptr[1].via.str);
+		CRI("Neovim reported an error: %.*s", (int)e->size, e->ptr);
+		goto fail;
+	} else if (err_type != MSGPACK_OBJECT_NIL) {
+		ERR("Error argument is of handled type 0x%x", err_type);
+		goto fail;
+	}
+
+	/* 4th argment, which contain the returned parameters */
+	return rpc->handlers->response(rpc->data, req_id, &(args->ptr[3]));
+
+fail:
+	rpc->handlers->response(rpc->data, req_id, NULL);
+	return EINA_FALSE;
+}
+
+static Eina_Bool _handle_notification(struct rpc *rpc, const msgpack_object_array *args)
+{
+	/*
+	 * 2nd argument must be a string (or bin string).
+	 * It contains the METHOD to be called for the notification.
+	 */
+	Eina_Stringshare *const method = _stringshare_extract(&(args->ptr[1]));
+	if (EINA_UNLIKELY(!method)) {
+		CRI("Failed to create stringshare from Neovim method");
+		return EINA_FALSE;
+	}
+	DBG("Received notification '%s'", method);
+
+	/* 3rd argument must be an array of objects */
+	Eina_Bool ok = EINA_FALSE;
+	if (EINA_UNLIKELY(args->ptr[2].type != MSGPACK_OBJECT_ARRAY))
+		ERR("Third argument in notification is expected to be an array");
+	else
+		ok = rpc->handlers->notification(rpc->data, method, &(args->ptr[2].via.array));
+
+	eina_stringshare_del(method);
+	return ok;
+}
+
+Eina_Bool rpc_setup(struct rpc *const rpc, const struct rpc_handlers *const handlers,
+		    void *const data)
+{
+	EINA_SAFETY_ON_NULL_RETURN_VAL(handlers, EINA_FALSE);
+
+	rpc->handlers = handlers;
+	rpc->data = data;
+
+	if (EINA_UNLIKELY(!msgpack_unpacker_init(&rpc->unpacker, 2048))) {
+		CRI("Failed to initialize the msgpack unpacker");
+		return EINA_FALSE;
+	}
+	msgpack_sbuffer_init(&rpc->sbuffer);
+	msgpack_packer_init(&rpc->packer, &rpc->sbuffer, msgpack_sbuffer_write);
+	_rpc_mem_update(rpc);
+	return EINA_TRUE;
+}
+
+void rpc_cleanup(struct rpc *const rpc)
+{
+	msgpack_sbuffer_destroy(&rpc->sbuffer);
+	msgpack_unpacker_destroy(&rpc->unpacker);
+	mem_usage_update(MEM_POOL_RPC, &rpc->mem, 0u);
+}
+
+uint32_t rpc_next_uid_get(struct rpc *const rpc)
+{
+	/* Overflow is not an error */
+	return rpc->request_id++;
+}
+
+Eina_Bool rpc_flush(struct rpc *const rpc)
+{
+	/* The send buffer is at its largest right before being sent */
+	_rpc_mem_update(rpc);
+
+	/* Send the data present in the msgpack buffer */
+	const Eina_Bool ok = rpc->handlers->send(rpc->data, rpc->sbuffer.data, rpc->sbuffer.size);
+
+	/* Now that the data is gone (hopefully), clear the buffer */
+	if (EINA_UNLIKELY(!ok)) {
+		CRI("Failed to send %zu bytes to neovim", rpc->sbuffer.size);
+		msgpack_sbuffer_clear(&rpc->sbuffer);
+		return EINA_FALSE;
+	}
+	DBG("Sent %zu bytes to neovim", rpc->sbuffer.size);
+	rpc->bytes.sent += rpc->sbuffer.size;
+	msgpack_sbuffer_clear(&rpc->sbuffer);
+	return EINA_TRUE;
+}
+
+Eina_Bool rpc_data_feed(struct rpc *const rpc, const void *const bytes, const size_t size)
+{
+	msgpack_unpacker *const unpacker = &rpc->unpacker;
+
+	rpc->bytes.received += size;
+
+	/* Resize the unpacking buffer if need be */
+	if (msgpack_unpacker_buffer_capacity(unpacker) < size) {
+		const bool ret = msgpack_unpacker_reserve_buffer(unpacker, size);
+		if (!ret) {
+			ERR("Memory reallocation of %zu bytes failed", size);
+			return EINA_FALSE;
+		}
+		_rpc_mem_update(rpc);
+	}
+	/* This seems to be required, but that's plain inefficiency */
+	memcpy(msgpack_unpacker_buffer(unpacker), bytes, size);
+	msgpack_unpacker_buffer_consumed(unpacker, size);
+	return EINA_TRUE;
+}
+
+Eina_Bool rpc_data_dispatch(struct rpc *const rpc, const double budget, Eina_Bool *const pending)
+{
+	msgpack_unpacker *const unpacker = &rpc->unpacker;
+	const double deadline = (budget >= 0.0) ? _now() + budget : 0.0;
+	Eina_Bool ok = EINA_FALSE;
+
+	if (pending)
+		*pending = EINA_FALSE;
+
+	msgpack_unpacked result;
+	msgpack_unpacked_init(&result);
+	for (;;) {
+		const msgpack_unpack_return ret = msgpack_unpacker_next(unpacker, &result);
+		if (ret == MSGPACK_UNPACK_CONTINUE) {
+			break;
+		} else if (EINA_UNLIKELY(ret != MSGPACK_UNPACK_SUCCESS)) {
+			ERR("Error while unpacking data from neovim (0x%x)", ret);
+			goto end;
+		}
+		const msgpack_object *const obj = &(result.data);
+
+#if 0 /* Uncomment to roughly dump the received messages */
+		msgpack_object_print(stderr, *obj);
+		fprintf(stderr, "\n--------\n");
+#endif
+
+		if (EINA_UNLIKELY(obj->type != MSGPACK_OBJECT_ARRAY)) {
+			ERR("Unexpected msgpack type 0x%x", obj->type);
+			goto end;
+		}
+
+		const msgpack_object_array *const args = &(obj->via.array);
+		const unsigned int response_args_count = 4u;
+		const unsigned int notif_args_count = 3u;
+		if ((args->size != response_args_count) && (args->size != notif_args_count)) {
+			ERR("Unexpected count of arguments: %u.", args->size);
+			goto end;
+		}
+
+		if (EINA_UNLIKELY(args->ptr[0].type != MSGPACK_OBJECT_POSITIVE_INTEGER)) {
+			ERR("First argument in response is expected to be an integer");
+			goto end;
+		}
+		const uint64_t type = args->ptr[0].via.u64;
+		if ((type == 0) && (args->size == response_args_count)) /* request */
+			_handle_request(rpc, args);
+		else if ((type == 1) && (args->size == response_args_count)) /* response */
+			_handle_request_response(rpc, args);
+		else if ((type == 2) && (args->size == notif_args_count)) /* notification */
+			_handle_notification(rpc, args);
+		else {
+			ERR("Invalid message identifier %" PRIu64 " (%u arguments)", type,
+			    args->size);
+			goto end;
+		}
+
+		/* The messages left are processed by the next call. There may be
+		 * none: it is only known by unpacking the next one */
+		if ((budget >= 0.0) && (_now() >= deadline) &&
+		    (_backlog_get(unpacker) <= RPC_BACKLOG_MAX)) {
+			if (pending)
+				*pending = EINA_TRUE;
+			break;
+		}
+	} /* End of message unpacking */
+	ok = EINA_TRUE;
+
+end:
+	msgpack_unpacked_destroy(&result);
+	return ok;
+}
+
+Eina_Bool rpc_data_process(struct rpc *const rpc, const void *const bytes, const size_t size)
+{
+	return rpc_data_feed(rpc, bytes, size) && rpc_data_dispatch(rpc, -1.0, NULL);
+}
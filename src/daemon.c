@@ -0,0 +1,492 @@
+/* This file is part of Eovim, which is under the MIT License ****************/
+
+#include "eovim/daemon.h"
+#include "eovim/nvim.h"
+#include "eovim/nvim_helper.h"
+#include "eovim/rpc.h"
+#include "eovim/log.h"
+
+#include <Ecore_Con.h>
+#include <limits.h>
+#include <unistd.h>
+
+/* Name of the local socket. It lives in the user's directory */
+#define DAEMON_SOCKET "eovim"
+
+/* Count of warm neovim instances that wait for a client */
+#define DAEMON_SPARES 2u
+
+/* Delay (in seconds) after which a client stops waiting for the daemon */
+#define DAEMON_CLIENT_TIMEOUT 2.0
+
+/* A client connected to the daemon */
+struct client {
+	Ecore_Con_Client *con;
+	struct rpc rpc;
+};
+
+/* The request of a client to the daemon */
+struct open_request {
+	Ecore_Con_Server *server;
+	const char *const *files;
+	struct rpc rpc;
+	Eina_Bool opened;
+};
+
+static Ecore_Con_Server *_server = NULL;
+static Ecore_Event_Handler *_handlers[4];
+static Eina_List *_clients = NULL;
+static Eina_List *_spares = NULL; /**< Warm neovim instances */
+static const struct options *_opts = NULL;
+static const char *const *_args = NULL;
+
+static void _pack_string(msgpack_packer *const pk, const char *const str, const size_t len)
+{
+	msgpack_pack_str(pk, len);
+	msgpack_pack_str_body(pk, str, len);
+}
+
+/*============================================================================*
+ *                              Neovim Instances                              *
+ *============================================================================*/
+
+static Eina_Bool _exe_del_cb(void *const data EINA_UNUSED, const int type EINA_UNUSED,
+			     void *const event)
+{
+	/* A warm instance that died cannot be handed over anymore. The neovim
+	 * handle is still valid, as its own handlers are called after ours */
+	const Ecore_Exe_Event_Del *const info = event;
+	Eina_List *l;
+	struct nvim *nvim;
+
+	EINA_LIST_FOREACH(_spares, l, nvim)
+	{
+		if (nvim->exe == info->exe) {
+			_spares = eina_list_remove_list(_spares, l);
+			break;
+		}
+	}
+	return ECORE_CALLBACK_PASS_ON;
+}
+
+static void _spares_fill(void)
+{
+	while (eina_list_count(_spares) < DAEMON_SPARES) {
+		struct nvim *const nvim = nvim_new(_opts, _args);
+		if (EINA_UNLIKELY(!nvim)) {
+			CRI("Failed to create a neovim instance");
+			break;
+		}
+		_spares = eina_list_append(_spares, nvim);
+	}
+}
+
+static struct nvim *_spare_take(void)
+{
+	struct nvim *const nvim = eina_list_data_get(_spares);
+	if (EINA_LIKELY(nvim != NULL)) {
+		_spares = eina_list_remove_list(_spares, _spares);
+		return nvim;
+	}
+
+	/* No warm instance is left. This one will start from scratch, but
+	 * eovim is still ready */
+	WRN("No warm neovim instance is available");
+	return nvim_new(_opts, _args);
+}
+
+/*============================================================================*
+ *                            Daemon-side Clients                             *
+ *============================================================================*/
+
+static const char *_open_request_handle(const msgpack_object_array *const args)
+{
+	struct nvim *const nvim = _spare_take();
+	if (EINA_UNLIKELY(!nvim))
+		return "failed to create a neovim instance";
+
+	/* Files are relative to the working directory of the client */
+	if (EINA_UNLIKELY(!nvim_helper_files_open(nvim, args))) {
+		_spares = eina_list_prepend(_spares, nvim);
+		return "failed to open the files";
+	}
+	evas_object_show(nvim->gui.win);
+	elm_win_activate(nvim->gui.win);
+	return NULL;
+}
+
+static Eina_Bool _client_request_cb(void *const data, const uint32_t req_id,
+				    Eina_Stringshare *const method,
+				    const msgpack_object_array *const args)
+{
+	struct client *const client = data;
+	msgpack_packer *const pk = &client->rpc.packer;
+
+	const char *const error =
+		(!strcmp(method, "open")) ? _open_request_handle(args) : "unknown request";
+
+	/* See msgpack-rpc request response. Errors are formatted as neovim does */
+	msgpack_pack_array(pk, 4);
+	msgpack_pack_int(pk, 1);
+	msgpack_pack_uint32(pk, req_id);
+	if (error) {
+		ERR("Failed to process request '%s': %s", method, error);
+		msgpack_pack_array(pk, 2);
+		msgpack_pack_int(pk, 0);
+		_pack_string(pk, error, strlen(error));
+		msgpack_pack_nil(pk);
+	} else {
+		msgpack_pack_nil(pk);
+		msgpack_pack_true(pk);
+	}
+	rpc_flush(&client->rpc);
+
+	/* Replace the instance that was handed over */
+	if (!error)
+		_spares_fill();
+	return !error;
+}
+
+static Eina_Bool _client_response_cb(void *const data EINA_UNUSED, const uint32_t req_id,
+				     const msgpack_object *const result EINA_UNUSED)
+{
+	ERR("Unexpected response to request %" PRIu32 " from a client", req_id);
+	return EINA_FALSE;
+}
+
+static Eina_Bool _client_notification_cb(void *const data EINA_UNUSED,
+					 Eina_Stringshare *const method,
+					 const msgpack_object_array *const args EINA_UNUSED)
+{
+	ERR("Unexpected notification '%s' from a client", method);
+	return EINA_FALSE;
+}
+
+static Eina_Bool _client_send_cb(void *const data, const void *const bytes, const size_t size)
+{
+	const struct client *const client = data;
+	return ecore_con_client_send(client->con, bytes, (int)size) == (int)size;
+}
+
+static const struct rpc_handlers _client_rpc_handlers = {
+	.request = &_client_request_cb,
+	.response = &_client_response_cb,
+	.notification = &_client_notification_cb,
+	.send = &_client_send_cb,
+};
+
+static void _client_free(struct client *const client)
+{
+	rpc_cleanup(&client->rpc);
+	free(client);
+}
+
+static Eina_Bool _client_add_cb(void *const data EINA_UNUSED, const int type EINA_UNUSED,
+				void *const event)
+{
+	const Ecore_Con_Event_Client_Add *const info = event;
+	if (ecore_con_client_server_get(info->client) != _server)
+		return ECORE_CALLBACK_PASS_ON;
+
+	struct client *const client = calloc(1, sizeof(struct client));
+	if (EINA_UNLIKELY(!client)) {
+		CRI("Failed to allocate memory");
+		goto fail;
+	}
+	if (EINA_UNLIKELY(!rpc_setup(&client->rpc, &_client_rpc_handlers, client))) {
+		CRI("Failed to setup the RPC client");
+		free(client);
+		goto fail;
+	}
+	client->con = info->client;
+	ecore_con_client_data_set(info->client, client);
+	_clients = eina_list_append(_clients, client);
+	DBG("A client connected to the daemon");
+	return ECORE_CALLBACK_DONE;
+
+fail:
+	ecore_con_client_del(info->client);
+	return ECORE_CALLBACK_DONE;
+}
+
+static Eina_Bool _client_del_cb(void *const data EINA_UNUSED, const int type EINA_UNUSED,
+				void *const event)
+{
+	const Ecore_Con_Event_Client_Del *const info = event;
+	if (ecore_con_client_server_get(info->client) != _server)
+		return ECORE_CALLBACK_PASS_ON;
+
+	struct client *const client = ecore_con_client_data_get(info->client);
+	if (client) {
+		_clients = eina_list_remove(_clients, client);
+		_client_free(client);
+	}
+	ecore_con_client_del(info->client);
+	return ECORE_CALLBACK_DONE;
+}
+
+static Eina_Bool _client_data_cb(void *const data EINA_UNUSED, const int type EINA_UNUSED,
+				 void *const event)
+{
+	const Ecore_Con_Event_Client_Data *const info = event;
+	if (ecore_con_client_server_get(info->client) != _server)
+		return ECORE_CALLBACK_PASS_ON;
+
+	struct client *const client = ecore_con_client_data_get(info->client);
+	if (EINA_LIKELY(client != NULL))
+		rpc_data_process(&client->rpc, info->data, (size_t)info->size);
+	return ECORE_CALLBACK_DONE;
+}
+
+/*============================================================================*
+ *                              Client-side API                               *
+ *============================================================================*/
+
+static void _open_request_send(struct open_request *const req)
+{
+	char cwd[PATH_MAX];
+	if (EINA_UNLIKELY(!getcwd(cwd, sizeof(cwd)))) {
+		ERR("Failed to get the current working directory: %s", strerror(errno));
+		ecore_main_loop_quit();
+		return;
+	}
+
+	uint32_t count = 0u;
+	while (req->files[count] != NULL)
+		count++;
+
+	msgpack_packer *const pk = &req->rpc.packer;
+	const char method[] = "open";
+	msgpack_pack_array(pk, 4);
+	msgpack_pack_int(pk, 0);
+	msgpack_pack_uint32(pk, rpc_next_uid_get(&req->rpc));
+	_pack_string(pk, method, sizeof(method) - 1u);
+	msgpack_pack_array(pk, 2);
+	_pack_string(pk, cwd, strlen(cwd));
+	msgpack_pack_array(pk, count);
+	for (uint32_t i = 0u; i < count; i++)
+		_pack_string(pk, req->files[i], strlen(req->files[i]));
+	if (EINA_UNLIKELY(!rpc_flush(&req->rpc)))
+		ecore_main_loop_quit();
+}
+
+static Eina_Bool _open_response_cb(void *const data, const uint32_t req_id EINA_UNUSED,
+				   const msgpack_object *const result)
+{
+	/* Errors were already reported, and come without result */
+	struct open_request *const req = data;
+	req->opened = (result != NULL);
+	ecore_main_loop_quit();
+	return EINA_TRUE;
+}
+
+static Eina_Bool _open_request_cb(void *const data EINA_UNUSED, const uint32_t req_id,
+				  Eina_Stringshare *const method EINA_UNUSED,
+				  const msgpack_object_array *const args EINA_UNUSED)
+{
+	ERR("Unexpected request %" PRIu32 " from the daemon", req_id);
+	return EINA_FALSE;
+}
+
+static Eina_Bool _open_notification_cb(void *const data EINA_UNUSED,
+				       Eina_Stringshare *const method,
+				       const msgpack_object_array *const args EINA_UNUSED)
+{
+	ERR("Unexpected notification '%s' from the daemon", method);
+	return EINA_FALSE;
+}
+
+static Eina_Bool _open_send_cb(void *const data, const void *const bytes, const size_t size)
+{
+	const struct open_request *const req = data;
+	return ecore_con_server_send(req->server, bytes, (int)size) == (int)size;
+}
+
+static const struct rpc_handlers _open_rpc_handlers = {
+	.request = &_open_request_cb,
+	.response = &_open_response_cb,
+	.notification = &_open_notification_cb,
+	.send = &_open_send_cb,
+};
+
+static Eina_Bool _server_add_cb(void *const data, const int type EINA_UNUSED, void *const event)
+{
+	const Ecore_Con_Event_Server_Add *const info = event;
+	struct open_request *const req = data;
+	if (info->server == req->server)
+		_open_request_send(req);
+	return ECORE_CALLBACK_PASS_ON;
+}
+
+static Eina_Bool _server_del_cb(void *const data, const int type EINA_UNUSED, void *const event)
+{
+	/* The daemon is gone (or was never there) */
+	const Ecore_Con_Event_Server_Del *const info = event;
+	const struct open_request *const req = data;
+	if (info->server == req->server)
+		ecore_main_loop_quit();
+	return ECORE_CALLBACK_PASS_ON;
+}
+
+static Eina_Bool _server_data_cb(void *const data, const int type EINA_UNUSED, void *const event)
+{
+	const Ecore_Con_Event_Server_Data *const info = event;
+	struct open_request *const req = data;
+	if (info->server == req->server)
+		rpc_data_process(&req->rpc, info->data, (size_t)info->size);
+	return ECORE_CALLBACK_PASS_ON;
+}
+
+static Eina_Bool _client_timeout_cb(void *const data)
+{
+	Ecore_Timer **const timer = data;
+	*timer = NULL;
+	ERR("The daemon did not reply within %.1f seconds", DAEMON_CLIENT_TIMEOUT);
+	ecore_main_loop_quit();
+	return ECORE_CALLBACK_CANCEL;
+}
+
+/*============================================================================*
+ *                                 Public API                                 *
+ *============================================================================*/
+
+Eina_Bool daemon_start(const struct options *const opts, const char *const args[])
+{
+	EINA_SAFETY_ON_NULL_RETURN_VAL(opts, EINA_FALSE);
+
+	_opts = opts;
+	_args = args;
+
+	/* The Ecore_Con events only exist once the library is initialized */
+	if (EINA_UNLIKELY(!ecore_con_init())) {
+		CRI("Failed to initialize Ecore_Con");
+		return EINA_FALSE;
+	}
+
+	/* Our handler of ECORE_EXE_EVENT_DEL is called before the ones of the
+	 * neovim instances, which are created afterwards */
+	struct {
+		const int event;
+		const Ecore_Event_Handler_Cb callback;
+	} const ctor[] = {
+		{
+			.event = ECORE_EXE_EVENT_DEL,
+			.callback = _exe_del_cb,
+		},
+		{
+			.event = ECORE_CON_EVENT_CLIENT_ADD,
+			.callback = _client_add_cb,
+		},
+		{
+			.event = ECORE_CON_EVENT_CLIENT_DEL,
+			.callback = _client_del_cb,
+		},
+		{
+			.event = ECORE_CON_EVENT_CLIENT_DATA,
+			.callback = _client_data_cb,
+		},
+	};
+	static_assert(EINA_C_ARRAY_LENGTH(ctor) == EINA_C_ARRAY_LENGTH(_handlers),
+		      "Please fix your code!");
+	size_t i = 0;
+
+	for (; i < EINA_C_ARRAY_LENGTH(ctor); i++) {
+		_handlers[i] = ecore_event_handler_add(ctor[i].event, ctor[i].callback, NULL);
+		if (EINA_UNLIKELY(!_handlers[i])) {
+			CRI("Failed to create handler for event 0x%x", ctor[i].event);
+			goto del_handlers;
+		}
+	}
+
+	_server = ecore_con_server_add(ECORE_CON_LOCAL_USER, DAEMON_SOCKET, 0, NULL);
+	if (EINA_UNLIKELY(!_server)) {
+		CRI("Failed to listen on the local socket '%s'. Is a daemon already running?",
+		    DAEMON_SOCKET);
+		goto del_handlers;
+	}
+
+	_spares_fill();
+	if (EINA_UNLIKELY(!_spares)) {
+		CRI("Failed to create any neovim instance");
+		goto del_server;
+	}
+	INF("Daemon is ready with %u neovim instance(s)", eina_list_count(_spares));
+	return EINA_TRUE;
+
+del_server:
+	ecore_con_server_del(_server);
+	_server = NULL;
+del_handlers:
+	for (--i; i != SIZE_MAX; i--)
+		ecore_event_handler_del(_handlers[i]);
+	ecore_con_shutdown();
+	return EINA_FALSE;
+}
+
+void daemon_stop(void)
+{
+	struct client *client;
+	EINA_LIST_FREE(_clients, client)
+	{
+		ecore_con_client_data_set(client->con, NULL);
+		_client_free(client);
+	}
+	ecore_con_server_del(_server);
+	_server = NULL;
+
+	/* The instances themselves are released by nvim_free_all() */
+	_spares = eina_list_free(_spares);
+
+	for (size_t i = 0; i < EINA_C_ARRAY_LENGTH(_handlers); i++)
+		ecore_event_handler_del(_handlers[i]);
+	ecore_con_shutdown();
+}
+
+Eina_Bool daemon_client_open(const char *const files[])
+{
+	EINA_SAFETY_ON_NULL_RETURN_VAL(files, EINA_FALSE);
+
+	struct open_request req = {
+		.files = files,
+		.opened = EINA_FALSE,
+	};
+	Ecore_Event_Handler *handlers[3] = { NULL, NULL, NULL };
+	Ecore_Timer *timer = NULL;
+
+	if (EINA_UNLIKELY(!ecore_con_init())) {
+		CRI("Failed to initialize Ecore_Con");
+		return EINA_FALSE;
+	}
+	if (EINA_UNLIKELY(!rpc_setup(&req.rpc, &_open_rpc_handlers, &req))) {
+		CRI("Failed to setup the RPC client");
+		goto shutdown;
+	}
+
+	req.server = ecore_con_server_connect(ECORE_CON_LOCAL_USER, DAEMON_SOCKET, 0, NULL);
+	if (!req.server) {
+		INF("No eovim daemon is running");
+		goto rpc_cleanup;
+	}
+
+	/* The request is sent once we are connected. Wait for the response */
+	handlers[0] = ecore_event_handler_add(ECORE_CON_EVENT_SERVER_ADD, _server_add_cb, &req);
+	handlers[1] = ecore_event_handler_add(ECORE_CON_EVENT_SERVER_DEL, _server_del_cb, &req);
+	handlers[2] = ecore_event_handler_add(ECORE_CON_EVENT_SERVER_DATA, _server_data_cb, &req);
+	timer = ecore_timer_add(DAEMON_CLIENT_TIMEOUT, _client_timeout_cb, &timer);
+	if (EINA_LIKELY(handlers[0] && handlers[1] && handlers[2] && timer))
+		ecore_main_loop_begin();
+	else
+		CRI("Failed to create the handlers of the daemon's events");
+
+	if (timer)
+		ecore_timer_del(timer);
+	for (size_t i = 0; i < EINA_C_ARRAY_LENGTH(handlers); i++)
+		if (handlers[i])
+			ecore_event_handler_del(handlers[i]);
+	ecore_con_server_del(req.server);
+rpc_cleanup:
+	rpc_cleanup(&req.rpc);
+shutdown:
+	ecore_con_shutdown();
+	return req.opened;
+}
@@ -7,3 +7,44 @@ Eina_Bool nvim_event_eovim_reload(struct nvim *const nvim,
 {
 	return nvim_helper_config_reload(nvim);
 }
+
+Eina_Bool nvim_event_eovim_config(struct nvim *const nvim, const msgpack_object_array *const args)
+{
+	/* We expect: ["config", name, value]. It is sent by the runtime each
+	 * time a g:eovim_* variable is set */
+	CHECK_BASE_ARGS_COUNT(args, ==, 2);
+	const msgpack_object_str *const name =
+		MPACK_STRING_OBJ_EXTRACT(&args->ptr[1], return EINA_FALSE);
+	return nvim_helper_config_set(nvim, name, &args->ptr[2]);
+}
+
+Eina_Bool nvim_event_eovim_new_window(struct nvim *const nvim,
+				      const msgpack_object_array *const args)
+{
+	/* We expect: ["new_window", [cwd, [file...]]]. The new window gets its
+	 * own neovim, which shares the options of this one */
+	CHECK_BASE_ARGS_COUNT(args, ==, 1);
+	const msgpack_object_array *const params =
+		MPACK_ARRAY_EXTRACT(&args->ptr[1], return EINA_FALSE);
+
+	const char *const no_args[] = { NULL };
+	struct nvim *const new_nvim = nvim_new(nvim->opts, no_args);
+	if (EINA_UNLIKELY(!new_nvim)) {
+		ERR("Failed to create a new neovim instance");
+		return EINA_FALSE;
+	}
+
+	/* The daemon hides the windows it creates */
+	evas_object_show(new_nvim->gui.win);
+	return nvim_helper_files_open(new_nvim, params);
+}
+
+Eina_Bool nvim_event_eovim_clipboard_set(struct nvim *const nvim,
+					 const msgpack_object_array *const args)
+{
+	/* We expect: ["clipboard_set", [register, lines, regtype]] */
+	CHECK_BASE_ARGS_COUNT(args, ==, 1);
+	const msgpack_object_array *const params =
+		MPACK_ARRAY_EXTRACT(&args->ptr[1], return EINA_FALSE);
+	return clipboard_set(nvim, params);
+}
@@ -13,6 +13,7 @@
 #include "eovim/nvim.h"
 #include "eovim/nvim_event.h"
 #include "eovim/msgpack_helper.h"
+#include "eovim/clipboard.h"
 #include "eovim/log.h"
 
 /*
@@ -118,6 +119,9 @@ Eina_Bool nvim_event_popupmenu_select(struct nvim *nvim, const msgpack_object_ar
 /*****************************************************************************/
 
 Eina_Bool nvim_event_eovim_reload(struct nvim *nvim, const msgpack_object_array *args);
+Eina_Bool nvim_event_eovim_config(struct nvim *nvim, const msgpack_object_array *args);
+Eina_Bool nvim_event_eovim_new_window(struct nvim *nvim, const msgpack_object_array *args);
+Eina_Bool nvim_event_eovim_clipboard_set(struct nvim *nvim, const msgpack_object_array *args);
 
 /*****************************************************************************/
 
@@ -32,6 +32,9 @@ void gui_cmdline_show(struct gui *const gui, const char *const content,
 {
 	EINA_SAFETY_ON_NULL_RETURN(firstc);
 	struct nvim *const nvim = gui->nvim;
+	struct cmdline *const cmdline = cmdline_get(gui);
+	if (EINA_UNLIKELY(!cmdline))
+		return;
 
 	const Eina_Bool use_prompt = (firstc[0] == '\0');
 	const char *const prompt_signal =
@@ -47,7 +50,7 @@ void gui_cmdline_show(struct gui *const gui, const char *const content,
 		}
 	}
 
-	const struct termview_style *const style = eina_hash_find(nvim->hl_groups, hi_group);
+	const struct grid_style *const style = eina_hash_find(nvim->grid->hl_groups, hi_group);
 	if (EINA_UNLIKELY(!style)) {
 		ERR("Failed to find group for '%s'", hi_group);
 		goto end;
@@ -65,9 +68,9 @@ end:
 					    (use_prompt) ? prompt : firstc);
 
 	/* Show the completion panel */
-	if (!gui->cmdline->enabled) {
+	if (!cmdline->enabled) {
 		elm_layout_signal_emit(gui->layout, "eovim,cmdline,show", "eovim");
-		gui->cmdline->enabled = EINA_TRUE;
+		cmdline->enabled = EINA_TRUE;
 	}
 }
 
@@ -83,12 +86,13 @@ static void cmdline_shown_cb(void *const data, Evas_Object *const obj EINA_UNUSE
 void gui_cmdline_hide(struct gui *const gui)
 {
 	elm_layout_signal_emit(gui->layout, "eovim,cmdline,hide", "eovim");
-	gui->cmdline->enabled = EINA_FALSE;
+	if (gui->cmdline)
+		gui->cmdline->enabled = EINA_FALSE;
 }
 
 Eina_Bool gui_cmdline_enabled_get(const struct gui *const gui)
 {
-	return gui->cmdline->enabled;
+	return gui->cmdline && gui->cmdline->enabled;
 }
 
 void gui_cmdline_cursor_pos_set(struct gui *const gui, const size_t pos)
@@ -102,22 +106,28 @@ void gui_cmdline_cursor_pos_set(struct gui *const gui, const size_t pos)
 	gui_cursor_calc(gui, ox + cx, oy + cy, cw, ch);
 }
 
-struct cmdline *cmdline_add(struct gui *const gui)
+struct cmdline *cmdline_get(struct gui *const gui)
 {
-	struct cmdline *const cmd = calloc(1, sizeof(*cmd));
-	if (EINA_UNLIKELY(!cmd)) {
-		CRI("Failed to allocate memory");
-		return NULL;
+	/* The command-line is only created when it is first used */
+	if (!gui->cmdline) {
+		struct cmdline *const cmd = calloc(1, sizeof(*cmd));
+		if (EINA_UNLIKELY(!cmd)) {
+			CRI("Failed to allocate memory");
+			return NULL;
+		}
+		cmd->gui = gui;
+		cmd->buf = eina_strbuf_new();
+		elm_layout_signal_callback_add(gui->layout, "eovim,cmdline,shown", "eovim",
+					       &cmdline_shown_cb, cmd);
+		gui->cmdline = cmd;
 	}
-	cmd->gui = gui;
-	cmd->buf = eina_strbuf_new();
-	elm_layout_signal_callback_add(gui->layout, "eovim,cmdline,shown", "eovim",
-				       &cmdline_shown_cb, cmd);
-	return cmd;
+	return gui->cmdline;
 }
 
 void cmdline_del(struct cmdline *const cmd)
 {
-	eina_strbuf_free(cmd->buf);
-	free(cmd);
+	if (cmd) {
+		eina_strbuf_free(cmd->buf);
+		free(cmd);
+	}
 }
@@ -3,6 +3,7 @@
 #include <eovim/log.h>
 #include <eovim/gui.h>
 #include <eovim/main.h>
+#include <eovim/mem.h>
 
 #include "gui_private.h"
 
@@ -57,6 +58,7 @@ static struct completion_item *completion_item_new(struct completion *const cmpl
 		CRI("Failed to allocate memory (%zu bytes)", buf_size);
 		return NULL;
 	}
+	mem_alloc_account(MEM_POOL_COMPLETION, buf_size);
 	item->completion = cmpl;
 	char *buf = item->mem;
 
@@ -85,6 +87,9 @@ static struct completion_item *completion_item_new(struct completion *const cmpl
 static void completion_item_del(void *const data, Evas_Object *const obj EINA_UNUSED)
 {
 	struct completion_item *const item = data;
+	const size_t buf_size = sizeof(struct completion_item) + strlen(item->word) +
+				strlen(item->kind) + strlen(item->menu) + strlen(item->info) + 4u;
+	mem_free_account(MEM_POOL_COMPLETION, buf_size);
 	free(item);
 }
 
@@ -137,12 +142,22 @@ static Evas_Object *completion_resuable_content_get(void *const data, Evas_Objec
 	return old;
 }
 
+struct completion *gui_completion_get(struct gui *const gui)
+{
+	/* The completion popup is only created when it is first used */
+	if (!gui->completion)
+		gui->completion = gui_completion_add(gui);
+	return gui->completion;
+}
+
 void gui_completion_append(struct gui *const gui, const char *const word, const uint32_t word_size,
 			   const char *const kind, const uint32_t kind_size, const char *const menu,
 			   const uint32_t menu_size, const char *const info,
 			   const uint32_t info_size)
 {
-	struct completion *const cmpl = gui->completion;
+	struct completion *const cmpl = gui_completion_get(gui);
+	if (EINA_UNLIKELY(!cmpl))
+		return;
 	struct completion_item *const item = completion_item_new(
 		cmpl, word, word_size, kind, kind_size, menu, menu_size, info, info_size);
 	if (EINA_UNLIKELY(!item))
@@ -164,6 +179,9 @@ void gui_completion_append(struct gui *const gui, const char *const word, const
 
 void gui_completion_reset(struct gui *const gui)
 {
+	/* Nothing to reset if the completion popup was never used */
+	if (!gui->completion)
+		return;
 	popupmenu_clear(&gui->completion->pop);
 	gui->completion->has_kind = 0;
 	gui->completion->max_len = 0;
@@ -226,7 +244,9 @@ static void completion_resize(struct popupmenu *const pop)
 
 void gui_completion_show(struct gui *const gui, const unsigned int col, const unsigned int row)
 {
-	struct completion *const cmpl = gui->completion;
+	struct completion *const cmpl = gui_completion_get(gui);
+	if (EINA_UNLIKELY(!cmpl))
+		return;
 	struct popupmenu *const pop = &cmpl->pop;
 	gui->active_popup = pop;
 
@@ -269,15 +289,19 @@ struct completion *gui_completion_add(struct gui *const gui)
 
 void gui_completion_del(struct completion *const cmpl)
 {
-	popupmenu_del(&cmpl->pop);
-	free(cmpl);
+	if (cmpl) {
+		popupmenu_del(&cmpl->pop);
+		free(cmpl);
+	}
 }
 
 void gui_completion_style_set(struct completion *const cmpl,
 			      const Evas_Textblock_Style *const style, const unsigned int cell_w,
 			      const unsigned int cell_h)
 {
-	popupmenu_style_changed(&cmpl->pop, style, cell_w, cell_h);
+	/* A popup that is not created yet gets the style on creation */
+	if (cmpl)
+		popupmenu_style_changed(&cmpl->pop, style, cell_w, cell_h);
 }
 
 Eina_Bool gui_completion_init(void)
@@ -6,6 +6,8 @@
 #include <eovim/main.h>
 #include <eovim/log.h>
 #include <eovim/nvim_api.h>
+#include <eovim/bench.h>
+#include <eovim/paste.h>
 
 #include "gui_private.h"
 
@@ -37,6 +39,23 @@ static void _win_close_cb(void *data, Evas_Object *obj EINA_UNUSED, void *info E
 	nvim_api_command(nvim, cmd, sizeof(cmd) - 1, NULL, NULL);
 }
 
+static void _bench_render_post_cb(void *const data, Evas *const evas, void *const info EINA_UNUSED)
+{
+	/* We are only interested in the first frame that actually contains
+	 * something from neovim */
+	if (!bench_reached(BENCH_STAGE_FIRST_FLUSH))
+		return;
+
+	bench_mark(BENCH_STAGE_FIRST_FRAME);
+	evas_event_callback_del_full(evas, EVAS_CALLBACK_RENDER_POST, &_bench_render_post_cb, data);
+
+	/* We are done measuring: terminate neovim as if the window was closed.
+	 * Eovim will naturally stop when neovim exits. */
+	struct nvim *const nvim = data;
+	const char cmd[] = ":quitall!";
+	nvim_api_command(nvim, cmd, sizeof(cmd) - 1, NULL, NULL);
+}
+
 static void _termview_relayout_cb(void *const data, Evas_Object *const obj EINA_UNUSED,
 				  void *const info)
 {
@@ -45,25 +64,41 @@ static void _termview_relayout_cb(void *const data, Evas_Object *const obj EINA_
 	evas_object_resize(gui->win, geo->x + geo->w, geo->y + geo->h);
 }
 
+static Eina_Bool _paste_cb(void *const data, Evas_Object *const obj EINA_UNUSED,
+			   Elm_Selection_Data *const ev)
+{
+	struct gui *const gui = data;
+
+	/* The text may or may not be NUL-terminated */
+	const size_t len = strnlen(ev->data, ev->len);
+	if (len != 0u)
+		paste_start(gui->nvim, ev->data, len);
+	return EINA_TRUE;
+}
+
+void gui_paste(struct gui *const gui)
+{
+	/* The clipboard is read asynchronously: _paste_cb() gets its text */
+	if (EINA_UNLIKELY(!elm_cnp_selection_get(gui->win, ELM_SEL_TYPE_CLIPBOARD,
+						 ELM_SEL_FORMAT_TEXT, &_paste_cb, gui)))
+		ERR("Failed to request the contents of the clipboard");
+}
+
 Eina_Bool gui_add(struct gui *gui, struct nvim *nvim)
 {
 	EINA_SAFETY_ON_NULL_RETURN_VAL(gui, EINA_FALSE);
 
 	gui->nvim = nvim;
 
-	gui->tabs = eina_inarray_new(sizeof(unsigned int), 4);
-	if (EINA_UNLIKELY(!gui->tabs)) {
-		CRI("Failed to create inline array");
-		goto fail;
-	}
-
 	/* Window setup */
 	gui->win = elm_win_util_standard_add("eovim", "Eovim");
 	if (!gui->win) {
 		CRI("Failed to create window");
 		goto fail;
 	}
-	elm_win_autodel_set(gui->win, EINA_TRUE);
+	/* The window outlives the close request: it is deleted once neovim
+	 * exits, with the rest of the GUI. See nvim_new() */
+	elm_win_autodel_set(gui->win, EINA_FALSE);
 	evas_object_smart_callback_add(gui->win, "delete,request", _win_close_cb, nvim);
 
 	/* Main Layout setup */
@@ -73,6 +108,7 @@ Eina_Bool gui_add(struct gui *gui, struct nvim *nvim)
 		goto fail;
 	}
 	gui->edje = elm_layout_edje_get(gui->layout);
+	bench_mark(BENCH_STAGE_THEME);
 	elm_layout_signal_callback_add(gui->layout, "eovim,tabs,shown", "eovim", _tabs_shown_cb,
 				       nvim);
 	elm_win_resize_object_add(gui->win, gui->layout);
@@ -80,40 +116,41 @@ Eina_Bool gui_add(struct gui *gui, struct nvim *nvim)
 	evas_object_smart_callback_add(gui->win, "focus,out", _focus_out_cb, gui);
 	evas_object_smart_callback_add(gui->win, "focus,out", _focus_out_cb, gui);
 
+	/* Text dropped on the window is pasted */
+	elm_drop_target_add(gui->layout, ELM_SEL_FORMAT_TEXT, NULL, NULL, NULL, NULL, NULL, NULL,
+			    &_paste_cb, gui);
+
 	/* ========================================================================
 	 * Termview GUI objects
 	 * ===================================================================== */
 
 	gui->cursor = cursor_add(gui);
 
-	gui->cmdline = cmdline_add(gui);
-
+	/* The command-line, the wildmenu and the completion popup are created on
+	 * first use, or once the first frame is shown. See gui_ready_set() */
 	gui->termview = termview_add(gui->layout, nvim);
 	evas_object_smart_callback_add(gui->termview, "relayout", _termview_relayout_cb, gui);
 	evas_object_hide(gui->termview);
 
-	gui->wildmenu = gui_wildmenu_add(gui);
-	if (EINA_UNLIKELY(!gui->wildmenu))
-		return EINA_FALSE;
-
-	gui->completion = gui_completion_add(gui);
-	if (EINA_UNLIKELY(!gui->completion))
-		return EINA_FALSE;
-
 	/* ========================================================================
 	 * Finalize GUI
 	 * ===================================================================== */
 
 	gui_font_set(gui, "Courier", 14);
 
+	if (nvim->opts->bench_startup)
+		evas_event_callback_add(evas_object_evas_get(gui->win), EVAS_CALLBACK_RENDER_POST,
+					&_bench_render_post_cb, nvim);
+
 	gui_cmdline_hide(gui);
 	evas_object_show(gui->layout);
-	evas_object_show(gui->win);
+
+	/* The daemon keeps its windows hidden until they are handed over */
+	if (!nvim->opts->daemon)
+		evas_object_show(gui->win);
 	return EINA_TRUE;
 
 fail:
-	if (gui->tabs)
-		eina_inarray_free(gui->tabs);
 	evas_object_del(gui->win);
 	return EINA_FALSE;
 }
@@ -121,11 +158,15 @@ fail:
 void gui_del(struct gui *gui)
 {
 	EINA_SAFETY_ON_NULL_RETURN(gui);
+	if (gui->prewarm)
+		ecore_idler_del(gui->prewarm);
 	cursor_del(gui->cursor);
 	cmdline_del(gui->cmdline);
 	gui_wildmenu_del(gui->wildmenu);
 	gui_completion_del(gui->completion);
-	eina_inarray_free(gui->tabs);
+	hud_del(gui->hud);
+	if (gui->tabs)
+		eina_inarray_free(gui->tabs);
 	evas_object_del(gui->win);
 }
 
@@ -195,13 +236,10 @@ void gui_font_size_update(struct gui *const gui, const long new_size)
 	}
 }
 
-void gui_default_colors_set(struct gui *const gui, const union color fg, const union color bg,
-			    const union color sp)
+void gui_default_colors_set(struct gui *const gui, const union color fg, const union color bg)
 {
-	/* Change foreground and special (e.g. underline) colors */
-	termview_default_colors_set(gui->termview, fg, bg, sp);
-
-	/* TODO: mutualize this */
+	/* The termview gets the default colors from the grid. This only updates
+	 * the widgets around it. TODO: mutualize this */
 	gui->default_fg.value = fg.value;
 	color_class_set("eovim.background", bg);
 }
@@ -251,11 +289,55 @@ static void _maximized_cb(void *const data, Evas_Object *const obj EINA_UNUSED,
 	elm_win_fullscreen_set(gui->win, EINA_TRUE);
 }
 
+void gui_placeholder_show(struct gui *const gui)
+{
+	/* The termview is shown before neovim is ready, with whatever the grid
+	 * holds. gui_ready_set() will find it already in place */
+	elm_layout_content_set(gui->layout, "eovim.main.view", gui->termview);
+	evas_object_show(gui->termview);
+	termview_placeholder_show(gui->termview);
+}
+
+static Eina_Bool _prewarm_cb(void *const data)
+{
+	struct gui *const gui = data;
+
+	/* Create a single widget per idle iteration, so user input is never
+	 * delayed by more than one of them. Failures are not retried here */
+	if (!gui->wildmenu && gui_wildmenu_get(gui))
+		return ECORE_CALLBACK_RENEW;
+	if (!gui->completion && gui_completion_get(gui))
+		return ECORE_CALLBACK_RENEW;
+	if (!gui->cmdline && cmdline_get(gui))
+		return ECORE_CALLBACK_RENEW;
+
+	gui->prewarm = NULL;
+	return ECORE_CALLBACK_CANCEL;
+}
+
+static void _prewarm_render_post_cb(void *const data, Evas *const evas,
+				    void *const info EINA_UNUSED)
+{
+	struct gui *const gui = data;
+
+	/* Wait until a frame drawn by neovim is on screen */
+	if (gui->stats.flushes == 0u)
+		return;
+	evas_event_callback_del_full(evas, EVAS_CALLBACK_RENDER_POST, &_prewarm_render_post_cb,
+				     data);
+	gui->prewarm = ecore_idler_add(&_prewarm_cb, gui);
+}
+
 void gui_ready_set(struct gui *const gui)
 {
 	elm_layout_content_set(gui->layout, "eovim.main.view", gui->termview);
 	evas_object_show(gui->termview);
 
+	/* The widgets that are not needed for the first frame are created when
+	 * eovim becomes idle after it */
+	evas_event_callback_add(evas_object_evas_get(gui->win), EVAS_CALLBACK_RENDER_POST,
+				&_prewarm_render_post_cb, gui);
+
 	const struct options *const opts = gui->nvim->opts;
 
 	/* For maximize and fullscreen, we just update the window's dimensions.
@@ -356,6 +438,10 @@ static void _tab_activate_cb(void *data, Evas_Object *obj, const char *sig EINA_
 void gui_tabs_reset(struct gui *gui)
 {
 	gui->active_tab = 0;
+
+	/* Without tabs, the tabline was never populated */
+	if (!gui->tabs || (eina_inarray_count(gui->tabs) == 0u))
+		return;
 	eina_inarray_flush(gui->tabs);
 	edje_object_part_box_remove_all(gui->edje, "eovim.tabline", EINA_TRUE);
 }
@@ -374,6 +460,15 @@ void gui_tabs_add(struct gui *gui, const char *name, unsigned int id, Eina_Bool
 {
 	Evas *const evas = evas_object_evas_get(gui->layout);
 
+	/* The list of tabs is created when a second tab is first opened */
+	if (!gui->tabs) {
+		gui->tabs = eina_inarray_new(sizeof(unsigned int), 4);
+		if (EINA_UNLIKELY(!gui->tabs)) {
+			CRI("Failed to create inline array");
+			return;
+		}
+	}
+
 	/* Register the current tab */
 	eina_inarray_push(gui->tabs, &id);
 
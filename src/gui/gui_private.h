@@ -10,6 +10,7 @@
 struct gui;
 struct wildmenu;
 struct completion;
+struct hud;
 
 struct popupmenu_interface {
 	void (*const hide)(struct popupmenu *);
@@ -56,17 +57,21 @@ void popupmenu_style_changed(struct popupmenu *pop, const Evas_Textblock_Style *
 Evas_Object *popupmenu_item_use(const struct popupmenu *pop, Evas_Object *parent, Evas_Object *obj);
 
 struct wildmenu *gui_wildmenu_add(struct gui *gui);
+struct wildmenu *gui_wildmenu_get(struct gui *gui);
 void gui_wildmenu_del(struct wildmenu *wm);
 void gui_wildmenu_style_set(struct wildmenu *wm, const Evas_Textblock_Style *style,
 			    unsigned int cell_w, unsigned int cell_h);
 struct completion *gui_completion_add(struct gui *gui);
+struct completion *gui_completion_get(struct gui *gui);
 void gui_completion_style_set(struct completion *cmpl, const Evas_Textblock_Style *style,
 			      unsigned int cell_w, unsigned int cell_h);
 void gui_completion_del(struct completion *cmpl);
 
-struct cmdline *cmdline_add(struct gui *gui);
+struct cmdline *cmdline_get(struct gui *gui);
 void cmdline_del(struct cmdline *cmd);
 
+void hud_del(struct hud *hud);
+
 /*****************************************************************************
  * Cursor Internal API
  *****************************************************************************/
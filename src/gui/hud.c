@@ -0,0 +1,174 @@
+/* This file is part of Eovim, which is under the MIT License ****************/
+
+#include <eovim/gui.h>
+#include <eovim/nvim.h>
+#include <eovim/log.h>
+#include <eovim/mem.h>
+#include "gui_private.h"
+
+/* Period (in seconds) at which the HUD is refreshed */
+static const double HUD_PERIOD = 0.5;
+
+struct hud {
+	struct gui *gui;
+	Ecore_Timer *timer;
+	Eina_Strbuf *text;
+
+	/* Values of the counters when the HUD was last refreshed. They are used
+	 * to compute rates over the last period */
+	double last_time;
+	unsigned int frames;
+	unsigned int flushes;
+	double flush_time;
+	unsigned int dirty_rows;
+	size_t rpc_received;
+	size_t rpc_sent;
+	uint64_t allocations[__MEM_POOL_LAST];
+
+	/* Value of the flushes counter at the last frame counted */
+	unsigned int rendered_flushes;
+};
+
+static void _hud_allocations_save(struct hud *const hud)
+{
+	for (unsigned int i = 0u; i < __MEM_POOL_LAST; i++)
+		hud->allocations[i] = mem_stats_get(i)->allocations;
+}
+
+static void _render_post_cb(void *const data, Evas *const evas EINA_UNUSED,
+			    void *const info EINA_UNUSED)
+{
+	struct hud *const hud = data;
+	struct gui *const gui = hud->gui;
+
+	/* Only the frames that show a flush of neovim are counted: the HUD
+	 * itself, the cursor or the theme's animations render too */
+	if (gui->stats.flushes != hud->rendered_flushes) {
+		hud->rendered_flushes = gui->stats.flushes;
+		gui->stats.frames++;
+	}
+}
+
+static Eina_Bool _hud_refresh_cb(void *const data)
+{
+	struct hud *const hud = data;
+	struct gui *const gui = hud->gui;
+	const struct nvim *const nvim = gui->nvim;
+	Eina_Strbuf *const buf = hud->text;
+
+	const double now = ecore_time_get();
+	const double elapsed = now - hud->last_time;
+	if (EINA_UNLIKELY(elapsed <= 0.0))
+		return ECORE_CALLBACK_RENEW;
+
+	const unsigned int frames = gui->stats.frames - hud->frames;
+	const unsigned int flushes = gui->stats.flushes - hud->flushes;
+	const double flush_time = gui->stats.flush_time - hud->flush_time;
+	const unsigned int dirty_rows = gui->stats.dirty_rows - hud->dirty_rows;
+	const size_t received = nvim->rpc.bytes.received - hud->rpc_received;
+	const size_t sent = nvim->rpc.bytes.sent - hud->rpc_sent;
+
+	eina_strbuf_reset(buf);
+	eina_strbuf_append_printf(buf, "fps: %.1f<br>", (double)frames / elapsed);
+	eina_strbuf_append_printf(buf, "flush: %.3f ms avg, %.3f ms max<br>",
+				  flushes ? flush_time * 1e3 / (double)flushes : 0.0,
+				  gui->stats.flush_max * 1e3);
+	eina_strbuf_append_printf(buf, "dirty rows/frame: %.1f<br>",
+				  flushes ? (double)dirty_rows / (double)flushes : 0.0);
+	eina_strbuf_append_printf(buf, "rpc in: %.1f KiB/s<br>",
+				  (double)received / 1024.0 / elapsed);
+	eina_strbuf_append_printf(buf, "rpc out: %.1f KiB/s<br>", (double)sent / 1024.0 / elapsed);
+	eina_strbuf_append_printf(buf, "pending requests: %u<br>",
+				  eina_inlist_count(nvim->requests));
+	eina_strbuf_append_printf(buf, "style updates: %u", gui->stats.style_updates);
+	for (unsigned int i = 0u; i < __MEM_POOL_LAST; i++) {
+		const struct mem_stats *const stats = mem_stats_get(i);
+		const uint64_t allocations = stats->allocations - hud->allocations[i];
+		const double rate = (double)allocations / elapsed;
+		eina_strbuf_append_printf(buf, "<br>%s: %.1f KiB (peak %.1f), %.1f allocs/s",
+					  mem_pool_name_get(i), (double)stats->current / 1024.0,
+					  (double)stats->peak / 1024.0, rate);
+	}
+	elm_layout_text_set(gui->layout, "eovim.hud", eina_strbuf_string_get(buf));
+
+	hud->last_time = now;
+	hud->frames = gui->stats.frames;
+	hud->flushes = gui->stats.flushes;
+	hud->flush_time = gui->stats.flush_time;
+	gui->stats.flush_max = 0.0;
+	hud->dirty_rows = gui->stats.dirty_rows;
+	hud->rpc_received = nvim->rpc.bytes.received;
+	hud->rpc_sent = nvim->rpc.bytes.sent;
+	_hud_allocations_save(hud);
+	return ECORE_CALLBACK_RENEW;
+}
+
+static struct hud *_hud_add(struct gui *const gui)
+{
+	struct hud *const hud = calloc(1, sizeof(*hud));
+	if (EINA_UNLIKELY(!hud)) {
+		CRI("Failed to allocate memory");
+		goto fail;
+	}
+	hud->gui = gui;
+
+	hud->text = eina_strbuf_new();
+	if (EINA_UNLIKELY(!hud->text)) {
+		CRI("Failed to create string buffer");
+		goto free_hud;
+	}
+
+	hud->timer = ecore_timer_add(HUD_PERIOD, &_hud_refresh_cb, hud);
+	if (EINA_UNLIKELY(!hud->timer)) {
+		CRI("Failed to create timer");
+		goto free_text;
+	}
+
+	/* Frames are only counted while the HUD is displayed */
+	evas_event_callback_add(evas_object_evas_get(gui->win), EVAS_CALLBACK_RENDER_POST,
+				&_render_post_cb, hud);
+
+	hud->last_time = ecore_time_get();
+	hud->frames = gui->stats.frames;
+	hud->flushes = gui->stats.flushes;
+	hud->rendered_flushes = gui->stats.flushes;
+	hud->flush_time = gui->stats.flush_time;
+	gui->stats.flush_max = 0.0;
+	hud->dirty_rows = gui->stats.dirty_rows;
+	hud->rpc_received = gui->nvim->rpc.bytes.received;
+	hud->rpc_sent = gui->nvim->rpc.bytes.sent;
+	_hud_allocations_save(hud);
+
+	elm_layout_signal_emit(gui->layout, "eovim,hud,show", "eovim");
+	return hud;
+
+free_text:
+	eina_strbuf_free(hud->text);
+free_hud:
+	free(hud);
+fail:
+	return NULL;
+}
+
+void hud_del(struct hud *const hud)
+{
+	if (hud) {
+		struct gui *const gui = hud->gui;
+		evas_event_callback_del_full(evas_object_evas_get(gui->win),
+					     EVAS_CALLBACK_RENDER_POST, &_render_post_cb, hud);
+		elm_layout_signal_emit(gui->layout, "eovim,hud,hide", "eovim");
+		ecore_timer_del(hud->timer);
+		eina_strbuf_free(hud->text);
+		free(hud);
+	}
+}
+
+void gui_hud_enabled_set(struct gui *const gui, const Eina_Bool enabled)
+{
+	if (enabled && !gui->hud)
+		gui->hud = _hud_add(gui);
+	else if (!enabled && gui->hud) {
+		hud_del(gui->hud);
+		gui->hud = NULL;
+	}
+}
@@ -231,6 +231,13 @@ void popupmenu_setup(struct popupmenu *const pop, struct gui *const gui,
 
 	/* Create a string buffer for fast string composition */
 	pop->sbuf = eina_strbuf_new();
+
+	/* Popups are created on demand: the termview may have its style already */
+	unsigned int cell_w, cell_h;
+	termview_cell_size_get(gui->termview, &cell_w, &cell_h);
+	if (cell_w && cell_h)
+		popupmenu_style_changed(pop, termview_textblock_style_get(gui->termview), cell_w,
+					cell_h);
 }
 
 void popupmenu_del(struct popupmenu *const pop)
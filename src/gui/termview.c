@@ -1,22 +1,61 @@
 /* This file is part of Eovim, which is under the MIT License ****************/
 
 #include "eovim/termview.h"
+#include "eovim/grid.h"
 #include "eovim/log.h"
+#include "eovim/mem.h"
 #include "eovim/gui.h"
 #include "eovim/main.h"
 #include "eovim/keymap.h"
 #include "eovim/nvim_helper.h"
 #include "eovim/nvim_api.h"
 #include "eovim/nvim.h"
+#include "eovim/bench.h"
+#include "eovim/cache.h"
+#include "eovim/journal.h"
 
 #include "gui_private.h"
 
 #include <Edje.h>
+#include <Ecore_File.h>
 #include <Ecore_Input.h>
+#include <limits.h>
 
 static Evas_Smart *_smart = NULL;
 static Evas_Smart_Class _parent_sc = EVAS_SMART_CLASS_INIT_NULL;
 
+/* Size of a cell, for a given font name, size, line gap and scale. Measuring
+ * it loads the font in a textgrid and lays out the textblock, which all the
+ * termviews of the process can skip once it was done for one of them. The
+ * metrics are also kept on disk for the next runs */
+struct cell_metrics {
+	unsigned int w;
+	unsigned int h; /**< Height of a textgrid cell */
+	unsigned int line_h; /**< Height of a textblock line. 0 until measured */
+};
+static Eina_Hash *_cell_metrics = NULL;
+static Eina_Bool _cell_metrics_changed = EINA_FALSE;
+
+#define CELL_METRICS_CACHE "eovim/cell_metrics"
+#define CELL_METRICS_VERSION 1u
+
+/* Longest compose sequence that is followed, and longest name of a key within
+ * it. The sequences of Ecore are at most five keys long */
+#define COMPOSE_KEYS_MAX 8u
+#define COMPOSE_KEY_SIZE 32u
+
+/* Whether a key starts a compose sequence, by name of key. Only a few of them
+ * do (Multi_key and the dead keys). The compose table is asked the first time
+ * a key is pressed: after that, keys are only looked up */
+static Eina_Hash *_compose_starters = NULL;
+static const Eina_Bool _compose_starts = EINA_TRUE;
+static const Eina_Bool _compose_never = EINA_FALSE;
+
+/* Delay (in seconds) after which an input that did not cause neovim to redraw
+ * does not hold auto-repeated keys back anymore (e.g. moving down on the last
+ * line of a buffer does not redraw anything) */
+#define INPUT_REDRAW_TIMEOUT 0.1
+
 /* This is the invisible separator. A zero-width space character that
  * allows to split ligatures without changing underlying VISUAL REPRESENTATION
  * of the text.
@@ -38,12 +77,8 @@ static const char INVISIBLE_SEP[] = "\xe2\x81\xa5";
 struct termview;
 
 static void _relayout(struct termview *sd);
-
-struct cell {
-	char utf8[8]; /* NOT NUL-terminated */
-	uint32_t bytes;
-	uint32_t style_id;
-};
+static struct cell_metrics *_cell_metrics_get(const struct termview *sd);
+static const struct grid_backend _grid_backend;
 
 struct termview {
 	Evas_Object_Smart_Clipped_Data __clipped_data; /* Required by Evas */
@@ -51,20 +86,19 @@ struct termview {
 	Evas_Object *object;
 
 	struct nvim *nvim;
+	struct grid *grid; /**< The model we are rendering */
 	Evas_Object *textblock;
 	Ecore_Event_Handler *key_down_handler;
+	Ecore_Event_Handler *key_up_handler;
 	Eina_Strbuf *line;
-	struct cell **cells;
 	Evas_Textblock_Cursor **cursors;
 	Evas_Textblock_Cursor *tmp;
 
-	/* This per-row set of booleans is used to control which line has been
-	 * modified and needs to be re-rendered in the textblock.
-	 *
-	 * XXX It could/should be a bitmap to reduce space usage? XXX
-	 * XXX It could also contain information about columns??
-	 */
-	Eina_Bool *line_has_changed;
+	/* Size of the markup of each row, and their sum. This is how much the
+	 * textblock holds, not accounting for its internal structures */
+	size_t *markup_sizes;
+	size_t markup_size;
+	size_t markup_mem; /**< Share of MEM_POOL_TEXTBLOCK */
 
 	/* This textgrid exists to determine very easily the size of the a cell
 	 * after a font change. Otherwise, we have to go through a callback hell
@@ -77,9 +111,6 @@ struct termview {
 		unsigned int x;
 		unsigned int y;
 
-		unsigned int next_x;
-		unsigned int next_y;
-
 		/* This is set to true when the cursor has written a invisible
 		 * space. It should be at (x,y) */
 		Eina_Bool sep_written;
@@ -99,16 +130,42 @@ struct termview {
 		unsigned int prev_cy; /**< Previous Y position */
 	} mouse_drag;
 
-	Eina_List *seq_compose;
+	/* Keys of the compose sequence being typed. Empty when not composing */
+	struct {
+		char keys[COMPOSE_KEYS_MAX][COMPOSE_KEY_SIZE];
+		unsigned int count;
+	} compose;
+
+	/* Inputs (keys and mouse) received during an iteration of the main loop
+	 * are sent to neovim at its end, with a single nvim_input */
+	struct {
+		Eina_Strbuf *pending;
+		Ecore_Job *job;
+		double sent_at; /**< When the last input was sent */
+		Eina_Bool redraw_pending; /**< Neovim did not flush since then */
+
+		/* Mouse motion is coalesced while neovim did not redraw: only
+		 * the last position of a drag, and the sum of the wheel steps
+		 * are sent, with nvim_input_mouse */
+		struct {
+			Ecore_Timer *timer; /**< Sends the motion after a timeout */
+			int wheel_x; /**< Horizontal wheel steps. Negative is left */
+			int wheel_y; /**< Vertical wheel steps. Negative is up */
+			unsigned int wheel_cx; /**< Cell under the last wheel step */
+			unsigned int wheel_cy;
+			Eina_Bool drag; /**< The drag to mouse_drag.prev_c{x,y} */
+		} motion;
+
+		/* Auto-repeat detection */
+		unsigned int last_keycode;
+		unsigned int released_at; /**< Timestamp of the last key up */
+		Eina_Bool released; /**< The last key pressed was released */
+	} input;
 
-	Eina_Hash *styles;
 	struct {
 		Eina_Strbuf *text;
 
 		Evas_Textblock_Style *object;
-		union color default_fg;
-		union color default_bg;
-		union color default_sp;
 
 		Eina_Stringshare *font_name;
 		unsigned int font_size;
@@ -119,6 +176,7 @@ struct termview {
 	Eina_Bool pending_style_update;
 	Eina_Bool need_nvim_resize;
 	Eina_Bool mode_changed;
+	Eina_Bool insert_mode; /**< Neovim is in insert mode */
 
 	/***************************************************************************
 	 * The resize...
@@ -136,8 +194,8 @@ struct termview {
 	 * c - when the style change, we request a window resize
 	 *
 	 * This may cause loops. For example, when the user resizes the window,
-	 * we request a dimension change in neovim. This calls termview_matrix_set()
-	 * and a call to _relayout(). Relayout changes this window size...
+	 * we request a dimension change in neovim. This resizes the grid, which calls
+	 * _grid_resized_cb() and then _relayout(). Relayout changes this window size...
 	 *
 	 * The EFL do not provide (to the best of my knowledge) means to detect
 	 * a "resize,start" and "resize,end" event. There is just "resize".
@@ -147,17 +205,11 @@ struct termview {
 	 */
 	int in_resize;
 	Eina_Bool may_send_relayout;
-};
 
-static struct termview_style *_termview_style_new(void)
-{
-	return calloc(1, sizeof(struct termview_style));
-}
-
-static void _termview_style_free(struct termview_style *const style)
-{
-	free(style);
-}
+	/* The textblock shows a snapshot of a previous session, dimmed, until
+	 * neovim flushes its first frame */
+	Eina_Bool placeholder;
+};
 
 static Eina_Bool _kind_style_foreach(const Eina_Hash *const hash EINA_UNUSED, const void *const key,
 				     void *const data, void *const fdata)
@@ -172,19 +224,20 @@ static Eina_Bool _kind_style_foreach(const Eina_Hash *const hash EINA_UNUSED, co
 static Eina_Bool _style_foreach(const Eina_Hash *const hash EINA_UNUSED, const void *const key,
 				void *const data, void *const fdata)
 {
-	const struct termview_style *const style = data;
+	const struct grid_style *const style = data;
 	const int64_t style_id = *((const int64_t *)key);
 	struct termview *const sd = fdata;
+	const struct grid *const grid = sd->grid;
 	Eina_Strbuf *const buf = sd->style.text;
 
 	eina_strbuf_append_printf(buf, " X%" PRIx64 "='+", style_id);
 
 	if (style->reverse) {
 		const uint32_t fg = (style->bg_color.value == COLOR_DEFAULT) ?
-						  sd->style.default_bg.value :
+						  grid->default_bg.value :
 						  style->bg_color.value;
 		const uint32_t bg = (style->fg_color.value == COLOR_DEFAULT) ?
-						  sd->style.default_fg.value :
+						  grid->default_fg.value :
 						  style->fg_color.value;
 		eina_strbuf_append_printf(buf,
 					  " color=#%06" PRIx32
@@ -213,7 +266,7 @@ static Eina_Bool _style_foreach(const Eina_Hash *const hash EINA_UNUSED, const v
 					  style->fg_color.value & 0xFFFFFF);
 	}
 
-	const uint32_t sp = (style->sp_color.value == COLOR_DEFAULT) ? sd->style.default_sp.value :
+	const uint32_t sp = (style->sp_color.value == COLOR_DEFAULT) ? grid->default_sp.value :
 									     style->sp_color.value;
 	if (style->underline)
 		eina_strbuf_append_printf(buf,
@@ -240,21 +293,32 @@ void termview_style_update(Evas_Object *const obj)
 	eina_strbuf_reset(buf);
 	eina_strbuf_append_printf(buf, "DEFAULT='font=\\'%s\\' font_size=%u color=#%06x wrap=none",
 				  sd->style.font_name, sd->style.font_size,
-				  sd->style.default_fg.value & 0xFFFFFF);
+				  sd->grid->default_fg.value & 0xFFFFFF);
 	if (sd->style.line_gap != 0u) {
 		eina_strbuf_append_printf(buf, " linegap=%u", sd->style.line_gap);
 	}
 	eina_strbuf_append_char(buf, '\'');
 
-	eina_hash_foreach(sd->styles, &_style_foreach, sd);
+	eina_hash_foreach(sd->grid->styles, &_style_foreach, sd);
 	eina_hash_foreach(gui->nvim->kind_styles, &_kind_style_foreach, sd);
+	gui->stats.style_updates++;
 
 	//DBG("Style update: %s\n", eina_strbuf_string_get(buf));
 	evas_textblock_style_set(sd->style.object, eina_strbuf_string_get(buf));
 
-	/* The height of a "cell" may vary depending on the font, linegap, etc. */
-	evas_textblock_cursor_line_geometry_get(sd->cursors[0], NULL, NULL, NULL,
-						(int *)&sd->cell_h);
+	/* The height of a "cell" may vary depending on the font, linegap, etc.
+	 * Querying it lays out the textblock, unless it was measured before */
+	struct cell_metrics *const metrics = _cell_metrics_get(sd);
+	if (metrics && metrics->line_h) {
+		sd->cell_h = metrics->line_h;
+	} else {
+		evas_textblock_cursor_line_geometry_get(sd->cursors[0], NULL, NULL, NULL,
+							(int *)&sd->cell_h);
+		if (metrics && sd->cell_h) {
+			metrics->line_h = sd->cell_h;
+			_cell_metrics_changed = EINA_TRUE;
+		}
+	}
 
 	gui_wildmenu_style_set(gui->wildmenu, sd->style.object, sd->cell_w, sd->cell_h);
 	gui_completion_style_set(gui->completion, sd->style.object, sd->cell_w, sd->cell_h);
@@ -274,32 +338,197 @@ void termview_style_update(Evas_Object *const obj)
 	sd->need_nvim_resize = EINA_FALSE;
 }
 
+static const char *_mouse_button_to_string(int button)
+{
+	switch (button) {
+	case 3:
+		return "right";
+	case 2:
+		return "middle";
+	case 1: /* Fall through */
+	default:
+		return "left";
+	}
+}
+
+static inline Eina_Bool _motion_pending_is(const struct termview *const sd)
+{
+	return sd->input.motion.drag || sd->input.motion.wheel_y || sd->input.motion.wheel_x;
+}
+
+static void _input_sent(struct termview *const sd)
+{
+	sd->input.sent_at = ecore_loop_time_get();
+	sd->input.redraw_pending = EINA_TRUE;
+}
+
+static void _keys_flush(struct termview *const sd)
+{
+	Eina_Strbuf *const pending = sd->input.pending;
+	if (eina_strbuf_length_get(pending) == 0)
+		return;
+
+	nvim_api_input(sd->nvim, eina_strbuf_string_get(pending), eina_strbuf_length_get(pending));
+	eina_strbuf_reset(pending);
+	_input_sent(sd);
+}
+
+static void _wheel_send(struct termview *const sd, const char *const action, const int steps)
+{
+	/* Neovim has no count for scroll events: one event is sent per step */
+	for (int i = 0; i < steps; i++)
+		nvim_api_input_mouse(sd->nvim, "wheel", action, "", 0u, sd->input.motion.wheel_cy,
+				     sd->input.motion.wheel_cx);
+}
+
+static void _motion_commit(struct termview *const sd)
+{
+	if (!_motion_pending_is(sd))
+		return;
+
+	/* Mouse events are not sent along with the keys. The keys received
+	 * before the motion are sent first, so neovim gets them in order */
+	_keys_flush(sd);
+	if (sd->input.motion.drag) {
+		const char *const button = _mouse_button_to_string(sd->mouse_drag.btn);
+		nvim_api_input_mouse(sd->nvim, button, "drag", "", 0u, sd->mouse_drag.prev_cy,
+				     sd->mouse_drag.prev_cx);
+		sd->input.motion.drag = EINA_FALSE;
+		_input_sent(sd);
+	}
+
+	const int y = sd->input.motion.wheel_y;
+	const int x = sd->input.motion.wheel_x;
+	_wheel_send(sd, (y < 0) ? "up" : "down", abs(y));
+	_wheel_send(sd, (x < 0) ? "left" : "right", abs(x));
+	sd->input.motion.wheel_y = 0;
+	sd->input.motion.wheel_x = 0;
+	if (y || x) /* Unless the wheel steps cancelled out */
+		_input_sent(sd);
+}
+
+static void _input_flush_cb(void *const data)
+{
+	struct termview *const sd = data;
+
+	sd->input.job = NULL;
+	_motion_commit(sd);
+	_keys_flush(sd);
+}
+
+static void _input_job_ensure(struct termview *const sd)
+{
+	if (!sd->input.job) {
+		sd->input.job = ecore_job_add(&_input_flush_cb, sd);
+		if (EINA_UNLIKELY(!sd->input.job)) {
+			ERR("Failed to create job. Sending the input right away");
+			_input_flush_cb(sd);
+		}
+	}
+}
+
+static void _input_queue(struct termview *const sd, const char *const input, const size_t size)
+{
+	/* A burst of events (e.g. auto-repeated keys while neovim is busy) is
+	 * processed within a single iteration of the main loop. The job runs
+	 * after all of them, and sends them together */
+	_motion_commit(sd);
+	eina_strbuf_append_length(sd->input.pending, input, size);
+	_input_job_ensure(sd);
+}
+
+static Eina_Bool _motion_timer_cb(void *const data)
+{
+	struct termview *const sd = data;
+
+	/* Neovim did not redraw in time. Send the motion anyway */
+	sd->input.motion.timer = NULL;
+	if (_motion_pending_is(sd))
+		_input_job_ensure(sd);
+	return ECORE_CALLBACK_CANCEL;
+}
+
+static void _motion_queue(struct termview *const sd)
+{
+	/* Touchpads deliver mouse events much faster than neovim redraws. While
+	 * the previous input was not drawn, the motion is accumulated, and
+	 * termview_flush() sends it */
+	if (!sd->input.redraw_pending) {
+		_input_job_ensure(sd);
+		return;
+	}
+	const double elapsed = ecore_loop_time_get() - sd->input.sent_at;
+	if (elapsed >= INPUT_REDRAW_TIMEOUT)
+		_input_job_ensure(sd);
+	else if (!sd->input.motion.timer) {
+		sd->input.motion.timer =
+			ecore_timer_add(INPUT_REDRAW_TIMEOUT - elapsed, &_motion_timer_cb, sd);
+		if (EINA_UNLIKELY(!sd->input.motion.timer)) {
+			ERR("Failed to create timer. Sending the motion right away");
+			_input_job_ensure(sd);
+		}
+	}
+}
+
+static Eina_Bool _input_throttled_is(const struct termview *const sd)
+{
+	/* An input is held back while the last one sent did not cause neovim
+	 * to redraw yet. Inputs queued for the same iteration are sent together,
+	 * so they do not need to wait for each other */
+	return sd->input.redraw_pending &&
+	       (ecore_loop_time_get() - sd->input.sent_at < INPUT_REDRAW_TIMEOUT);
+}
+
 static void _keys_send(struct termview *sd, const char *keys, unsigned int size)
 {
-	nvim_api_input(sd->nvim, keys, size);
+	journal_input_add(sd->nvim->journal, JOURNAL_KIND_KEY, keys, size, EINA_FALSE);
+	_input_queue(sd, keys, size);
 	gui_cursor_key_pressed(&sd->nvim->gui);
 }
 
 static inline Eina_Bool _composing_is(const struct termview *sd)
 {
-	/* Composition is pending if the seq_compose list is not empty */
-	return (sd->seq_compose == NULL) ? EINA_FALSE : EINA_TRUE;
+	return sd->compose.count != 0u;
 }
 
 static inline void _composition_reset(struct termview *sd)
 {
-	/* Discard all elements within the list */
-	Eina_Stringshare *str;
-	EINA_LIST_FREE(sd->seq_compose, str)
-	eina_stringshare_del(str);
+	sd->compose.count = 0u;
 }
 
-static inline void _composition_add(struct termview *sd, const Ecore_Event_Key *const key)
+static Eina_Bool _composition_add(struct termview *sd, const Ecore_Event_Key *const key)
 {
-	/* Add the key as a stringshare in the seq list. Hence, starting the
-	 * composition */
-	Eina_Stringshare *const shr = eina_stringshare_add(key->key);
-	sd->seq_compose = eina_list_append(sd->seq_compose, shr);
+	/* A sequence that does not fit is not one of Ecore's */
+	const size_t len = strlen(key->key);
+	if (EINA_UNLIKELY((sd->compose.count == COMPOSE_KEYS_MAX) || (len >= COMPOSE_KEY_SIZE)))
+		return EINA_FALSE;
+	memcpy(sd->compose.keys[sd->compose.count++], key->key, len + 1u);
+	return EINA_TRUE;
+}
+
+static Ecore_Compose_State _composition_get(const struct termview *sd, char **const res)
+{
+	/* Ecore takes the sequence as a list. It is only built while composing,
+	 * which is seldom */
+	Eina_List *seq = NULL;
+	for (unsigned int i = 0u; i < sd->compose.count; i++)
+		seq = eina_list_append(seq, sd->compose.keys[i]);
+	const Ecore_Compose_State state = ecore_compose_get(seq, res);
+	eina_list_free(seq);
+	return state;
+}
+
+static Eina_Bool _composition_starts(const char *const key)
+{
+	const Eina_Bool *const known = eina_hash_find(_compose_starters, key);
+	if (EINA_LIKELY(known != NULL))
+		return *known;
+
+	Eina_List *const seq = eina_list_append(NULL, key);
+	const Eina_Bool starts = (ecore_compose_get(seq, NULL) == ECORE_COMPOSE_MIDDLE);
+	eina_list_free(seq);
+	eina_hash_add(_compose_starters, key, (starts) ? &_compose_starts : &_compose_never);
+	return starts;
 }
 
 /*
@@ -326,9 +555,12 @@ static Eina_Bool _compose(struct termview *const sd, const Ecore_Event_Key *cons
 		if (modifiers != 0u)
 			return EINA_TRUE;
 
-		/* Add the current key to the composition list, and compute */
-		_composition_add(sd, key);
-		const Ecore_Compose_State state = ecore_compose_get(sd->seq_compose, &res);
+		/* Add the current key to the composition sequence, and compute */
+		if (!_composition_add(sd, key)) {
+			_composition_reset(sd);
+			return EINA_FALSE;
+		}
+		const Ecore_Compose_State state = _composition_get(sd, &res);
 		if (state == ECORE_COMPOSE_DONE) {
 			/* We composed! Write the composed key! */
 			_composition_reset(sd);
@@ -341,17 +573,9 @@ static Eina_Bool _compose(struct termview *const sd, const Ecore_Event_Key *cons
 			/* The composition yield nothing. Reset */
 			_composition_reset(sd);
 		}
-	} else /* Not composing yet */
-	{
-		/* Add the key to the composition engine */
-		_composition_add(sd, key);
-		const Ecore_Compose_State state = ecore_compose_get(sd->seq_compose, NULL);
-		if (state != ECORE_COMPOSE_MIDDLE) {
-			/* Nope, this does not allow composition */
-			_composition_reset(sd);
-		} else {
-			return EINA_TRUE;
-		} /* Composing.... */
+	} else if (_composition_starts(key->key)) {
+		/* The key starts a sequence: composing.... */
+		return _composition_add(sd, key);
 	}
 
 	/* Delegate the key to the caller */
@@ -385,24 +609,20 @@ static void _coords_to_cell(const struct termview *sd, int px, int py, unsigned
 	}
 }
 
-static const char *_mouse_button_to_string(int button)
+static void _mouse_journal_add(struct termview *const sd, const enum journal_kind kind,
+			       const char *const button, const char *const action,
+			       const unsigned int cx, const unsigned int cy)
 {
-	switch (button) {
-	case 3:
-		return "Right";
-	case 2:
-		return "Middle";
-	case 1: /* Fall through */
-	default:
-		return "Left";
-	}
+	/* The journal truncates the input anyway */
+	char buf[64];
+	const int len = snprintf(buf, sizeof(buf), "%s %s %u,%u", button, action, cy, cx);
+	if (EINA_LIKELY((len > 0) && ((size_t)len < sizeof(buf))))
+		journal_input_add(sd->nvim->journal, kind, buf, (size_t)len, EINA_FALSE);
 }
 
-static void _mouse_event(struct termview *sd, const char *event, unsigned int cx, unsigned int cy,
+static void _mouse_event(struct termview *sd, const char *action, unsigned int cx, unsigned int cy,
 			 int btn)
 {
-	char input[64];
-
 	/* If mouse is NOT enabled, we don't handle mouse events */
 	if (!nvim_mouse_enabled_get(sd->nvim)) {
 		return;
@@ -410,11 +630,14 @@ static void _mouse_event(struct termview *sd, const char *event, unsigned int cx
 
 	/* Determine which button we pressed */
 	const char *const button = _mouse_button_to_string(btn);
+	_mouse_journal_add(sd, JOURNAL_KIND_MOUSE, button, action, cx, cy);
 
-	/* Convert the mouse input as an input format. */
-	const int bytes = snprintf(input, sizeof(input), "<%s%s><%u,%u>", button, event, cx, cy);
+	/* Whatever was received before must reach neovim first */
+	_motion_commit(sd);
+	_keys_flush(sd);
 
-	nvim_api_input(sd->nvim, input, (unsigned int)bytes);
+	nvim_api_input_mouse(sd->nvim, button, action, "", 0u, cy, cx);
+	_input_sent(sd);
 }
 
 static void _termview_mouse_move_cb(void *data, Evas *e EINA_UNUSED, Evas_Object *obj EINA_UNUSED,
@@ -436,13 +659,19 @@ static void _termview_mouse_move_cb(void *data, Evas *e EINA_UNUSED, Evas_Object
 	if ((cx == sd->mouse_drag.prev_cx) && (cy == sd->mouse_drag.prev_cy))
 		return;
 
-	/* At this point, we have actually moved the mouse while holding a mouse
-	 * button, hence dragging. Send the event then update the current mouse
-	 * position. */
-	_mouse_event(sd, "Drag", cx, cy, sd->mouse_drag.btn);
+	/* If mouse is NOT enabled, we don't handle mouse events */
+	if (!nvim_mouse_enabled_get(sd->nvim))
+		return;
 
+	/* At this point, we have actually moved the mouse while holding a mouse
+	 * button, hence dragging. Update the current mouse position: only the
+	 * last one is sent to neovim. */
 	sd->mouse_drag.prev_cx = cx;
 	sd->mouse_drag.prev_cy = cy;
+	sd->input.motion.drag = EINA_TRUE;
+	_mouse_journal_add(sd, JOURNAL_KIND_MOUSE, _mouse_button_to_string(sd->mouse_drag.btn),
+			   "drag", cx, cy);
+	_motion_queue(sd);
 }
 
 static void _termview_mouse_up_cb(void *data, Evas *e EINA_UNUSED, Evas_Object *obj EINA_UNUSED,
@@ -453,7 +682,7 @@ static void _termview_mouse_up_cb(void *data, Evas *e EINA_UNUSED, Evas_Object *
 	unsigned int cx, cy;
 
 	_coords_to_cell(sd, ev->canvas.x, ev->canvas.y, &cx, &cy);
-	_mouse_event(sd, "Release", cx, cy, ev->button);
+	_mouse_event(sd, "release", cx, cy, ev->button);
 	sd->mouse_drag.btn = 0; /* Disable mouse dragging */
 }
 
@@ -471,7 +700,7 @@ static void _termview_mouse_down_cb(void *data, Evas *e EINA_UNUSED, Evas_Object
 	sd->mouse_drag.prev_cx = cx;
 	sd->mouse_drag.prev_cy = cy;
 
-	_mouse_event(sd, "Mouse", cx, cy, ev->button);
+	_mouse_event(sd, "press", cx, cy, ev->button);
 	sd->mouse_drag.btn = ev->button; /* Enable mouse dragging */
 }
 
@@ -486,13 +715,19 @@ static void _termview_mouse_wheel_cb(void *data, Evas *e EINA_UNUSED, Evas_Objec
 		return;
 	}
 
-	const char *const dir = (ev->z < 0) ? "Up" : "Down";
-
-	char input[64];
-	unsigned int cx, cy;
-	_coords_to_cell(sd, ev->canvas.x, ev->canvas.y, &cx, &cy);
-	const int bytes = snprintf(input, sizeof(input), "<ScrollWheel%s><%u,%u>", dir, cx, cy);
-	nvim_api_input(sd->nvim, input, (unsigned int)bytes);
+	/* Steps are summed up, so opposite ones cancel out. Direction 1 is the
+	 * horizontal wheel */
+	if (ev->direction == 1)
+		sd->input.motion.wheel_x += ev->z;
+	else
+		sd->input.motion.wheel_y += ev->z;
+	_coords_to_cell(sd, ev->canvas.x, ev->canvas.y, &sd->input.motion.wheel_cx,
+			&sd->input.motion.wheel_cy);
+	const char *const action = (ev->direction == 1) ? ((ev->z < 0) ? "left" : "right")
+							: ((ev->z < 0) ? "up" : "down");
+	_mouse_journal_add(sd, JOURNAL_KIND_WHEEL, "wheel", action, sd->input.motion.wheel_cx,
+			   sd->input.motion.wheel_cy);
+	_motion_queue(sd);
 }
 
 /**
@@ -521,6 +756,22 @@ static Eina_Bool _add_modifier(char buf[64], const int cond, const char mod, int
 	return EINA_TRUE;
 }
 
+static void _echo_predict(struct termview *const sd, const char *const string)
+{
+	/* Only printable ASCII characters are known to be echoed as they are,
+	 * in a single cell */
+	if ((!string) || (string[0] < 0x20) || (string[0] > 0x7e) || (string[1] != '\0'))
+		return;
+
+	/* Draw the character right away, instead of waiting for neovim. The
+	 * next redraw of neovim reconciles it. Only its row changed */
+	const unsigned int row = sd->grid->cursor.y;
+	if (grid_predict(sd->grid, string, 1u)) {
+		grid_row_flush(sd->grid, row);
+		termview_redraw_end(sd->object);
+	}
+}
+
 static Eina_Bool _termview_key_down_cb(void *const data, const int type EINA_UNUSED,
 				       void *const event)
 {
@@ -530,9 +781,13 @@ static Eina_Bool _termview_key_down_cb(void *const data, const int type EINA_UNU
 	const struct keymap *const keymap = keymap_get(ev->key);
 	char buf[64];
 	const char *send;
-	const char caps[] = "Caps_Lock";
 	struct gui *const gui = &(sd->nvim->gui);
 
+	/* Key events are received for all the windows of the process. Only
+	 * consider the ones that were sent to our own window */
+	if (ev->window != elm_win_window_id_get(gui->win))
+		return ECORE_CALLBACK_PASS_ON;
+
 #if 0
    printf("key      : %s\n", ev->key);
    printf("keyname  : %s\n", ev->keyname);
@@ -544,7 +799,7 @@ static Eina_Bool _termview_key_down_cb(void *const data, const int type EINA_UNU
 
 	/* Did we press the Caps_Lock key? We can either have enabled or disabled
 	 * caps lock. */
-	if (!strcmp(ev->key, caps)) /* Caps lock is pressed */
+	if (keymap && keymap->caps_lock) /* Caps lock is pressed */
 	{
 		if (ev->modifiers & ECORE_EVENT_LOCK_CAPS) /* DISABLE */
 		{
@@ -559,10 +814,27 @@ static Eina_Bool _termview_key_down_cb(void *const data, const int type EINA_UNU
 		}
 	}
 
+	/* Auto-repeat sends key downs of the same key, without key up in between
+	 * (or with a key up at the very same time, on X11) */
+	const Eina_Bool repeated =
+		(ev->keycode == sd->input.last_keycode) &&
+		((!sd->input.released) || (sd->input.released_at == ev->timestamp));
+	sd->input.last_keycode = ev->keycode;
+	sd->input.released = EINA_FALSE;
+
 	/* If the key produces nothing. Stop */
-	if ((ev->string == NULL) && (keymap == NULL))
+	if ((ev->string == NULL) && ((keymap == NULL) || keymap->caps_lock))
 		return ECORE_CALLBACK_PASS_ON;
 
+	/* Held keys must not queue more inputs than neovim can process, or the
+	 * cursor keeps moving after they are released */
+	if (repeated && gui->key_repeat_throttle && _input_throttled_is(sd)) {
+		DBG("Dropping auto-repeated key '%s'", ev->key);
+		journal_input_add(sd->nvim->journal, JOURNAL_KIND_KEY, ev->key, strlen(ev->key),
+				  EINA_TRUE);
+		return ECORE_CALLBACK_PASS_ON;
+	}
+
 	/* Try the composition. When this function returns EINA_TRUE, it
 	 * already worked out, nothing more to do. */
 	if (_compose(sd, ev))
@@ -573,20 +845,27 @@ static Eina_Bool _termview_key_down_cb(void *const data, const int type EINA_UNU
 	const Eina_Bool alt = ev->modifiers & ECORE_EVENT_MODIFIER_ALT;
 	const Eina_Bool shift = ev->modifiers & ECORE_EVENT_MODIFIER_SHIFT;
 
-	/* Register modifiers. Ctrl and shift are special: we enable composition
-	 * only if the key is present in the keymap (it is a special key). We
-	 * disregard shift alone, because it would just mean "uppercase" if alone;
-	 * however when combined with the keymap, we will compose! */
-	const Eina_Bool compose = ctrl || super || alt || (shift && keymap);
-
-	if (compose) {
-		const char *const key = keymap ? keymap->name : ev->key;
-		if (!key) {
-			return ECORE_CALLBACK_PASS_ON;
-		}
+	/* Ctrl+Shift+V pastes the clipboard, as in terminal emulators */
+	if (ctrl && shift && (!super) && (!alt) && (!strcasecmp(ev->key, "v"))) {
+		gui_paste(gui);
+		return ECORE_CALLBACK_PASS_ON;
+	}
 
-		/* Compose a string containing the textual representation of the
-		 * special keys to be sent to neovim.
+	if (keymap) {
+		/* Special keys are translated with all their modifiers, shift
+		 * included, from the precomputed tables. E.g. <C-S-PageUp> */
+		const unsigned int mods =
+			(ctrl ? KEYMAP_MOD_CTRL : 0u) | (shift ? KEYMAP_MOD_SHIFT : 0u) |
+			(super ? KEYMAP_MOD_SUPER : 0u) | (alt ? KEYMAP_MOD_ALT : 0u);
+		const struct keymap_input *const input = &(keymap->inputs[mods]);
+		send = input->str;
+		send_size = (int)input->size;
+	} else if (ctrl || super || alt) {
+		/* We disregard shift alone, because it would just mean
+		 * "uppercase" for a regular key.
+		 *
+		 * Compose a string containing the textual representation of the
+		 * key to be sent to neovim.
 		 * Search :help META for details.
 		 *
 		 * We first compose the first part with the modifiers. E.g. <C-S-
@@ -609,20 +888,13 @@ static Eina_Bool _termview_key_down_cb(void *const data, const int type EINA_UNU
 		/* Add the real key after the modifier, and close the bracket */
 		assert(send_size < (int)sizeof(buf));
 		const size_t len = sizeof(buf) - (size_t)send_size;
-		const int ret = snprintf(buf + send_size, len, "%s>", key);
+		const int ret = snprintf(buf + send_size, len, "%s>", ev->key);
 		if (EINA_UNLIKELY(ret < 2)) {
 			ERR("Failed to compose key.");
 			return ECORE_CALLBACK_PASS_ON;
 		}
 		send_size += ret;
 		send = buf;
-	} else if (keymap) {
-		send_size = snprintf(buf, sizeof(buf), "<%s>", keymap->name);
-		if (EINA_UNLIKELY(send_size < 3)) {
-			ERR("Failed to write key to string");
-			return ECORE_CALLBACK_PASS_ON;
-		}
-		send = buf;
 	} else {
 		assert(ev->string != NULL);
 		send = ev->string;
@@ -630,13 +902,30 @@ static Eina_Bool _termview_key_down_cb(void *const data, const int type EINA_UNU
 	}
 
 	/* If a key is availabe pass it to neovim and update the ui */
-	if (EINA_LIKELY(send_size > 0))
+	if (EINA_LIKELY(send_size > 0)) {
 		_keys_send(sd, send, (unsigned int)send_size);
-	else
+		if (gui->predictive_echo && sd->insert_mode && !(ctrl || super || alt))
+			_echo_predict(sd, ev->string);
+	} else
 		DBG("Unhandled key '%s'", ev->key);
 	return ECORE_CALLBACK_PASS_ON;
 }
 
+static Eina_Bool _termview_key_up_cb(void *const data, const int type EINA_UNUSED,
+				     void *const event)
+{
+	struct termview *const sd = data;
+	const Ecore_Event_Key *const ev = event;
+
+	if (ev->window != elm_win_window_id_get(sd->nvim->gui.win))
+		return ECORE_CALLBACK_PASS_ON;
+	if (ev->keycode == sd->input.last_keycode) {
+		sd->input.released = EINA_TRUE;
+		sd->input.released_at = ev->timestamp;
+	}
+	return ECORE_CALLBACK_PASS_ON;
+}
+
 static void _termview_focus_in_cb(void *data, Evas *evas, Evas_Object *obj EINA_UNUSED,
 				  void *event EINA_UNUSED)
 {
@@ -730,8 +1019,8 @@ static void _smart_add(Evas_Object *obj)
     * the Evas that actually requires keyboard use */
 	sd->key_down_handler =
 		ecore_event_handler_add(ECORE_EVENT_KEY_DOWN, &_termview_key_down_cb, sd);
-
-	sd->styles = eina_hash_int64_new(EINA_FREE_CB(_termview_style_free));
+	sd->key_up_handler = ecore_event_handler_add(ECORE_EVENT_KEY_UP, &_termview_key_up_cb, sd);
+	sd->input.pending = eina_strbuf_new();
 
 	Evas *const evas = evas_object_evas_get(obj);
 	Evas_Object *o;
@@ -763,17 +1052,20 @@ static void _smart_del(Evas_Object *obj)
 	evas_textblock_style_free(sd->style.object);
 	eina_strbuf_free(sd->style.text);
 	eina_strbuf_free(sd->line);
-	eina_hash_free(sd->styles);
-	if (sd->cells) {
-		free(sd->cells[0]);
-		free(sd->cells);
-	}
-	free(sd->line_has_changed);
+	if (sd->grid)
+		grid_backend_set(sd->grid, NULL, NULL);
 	for (unsigned int i = 0u; i < sd->rows; i++)
 		evas_textblock_cursor_free(sd->cursors[i]);
 	free(sd->cursors);
+	free(sd->markup_sizes);
+	mem_usage_update(MEM_POOL_TEXTBLOCK, &sd->markup_mem, 0u);
 	ecore_event_handler_del(sd->key_down_handler);
-	_composition_reset(sd);
+	ecore_event_handler_del(sd->key_up_handler);
+	if (sd->input.job)
+		ecore_job_del(sd->input.job);
+	if (sd->input.motion.timer)
+		ecore_timer_del(sd->input.motion.timer);
+	eina_strbuf_free(sd->input.pending);
 }
 
 static void _smart_resize(Evas_Object *obj, Evas_Coord w, Evas_Coord h)
@@ -793,6 +1085,141 @@ static void _smart_resize(Evas_Object *obj, Evas_Coord w, Evas_Coord h)
 	}
 }
 
+static long long _fontconfig_stamp_get(void)
+{
+	/* Fontconfig rebuilds its caches when fonts are installed, updated or
+	 * removed. The metrics are stale as soon as one of them changed */
+	const char *const dirs[] = { "/var/cache/fontconfig", "/usr/lib/fontconfig/cache" };
+	long long stamp = 0;
+	char path[PATH_MAX];
+
+	for (size_t i = 0u; i < EINA_C_ARRAY_LENGTH(dirs); i++)
+		stamp = MAX(stamp, ecore_file_mod_time(dirs[i]));
+	if (cache_path_get(path, sizeof(path), "fontconfig"))
+		stamp = MAX(stamp, ecore_file_mod_time(path));
+	return stamp;
+}
+
+static void _cell_metrics_load(void)
+{
+	char path[PATH_MAX];
+	if (EINA_UNLIKELY(!cache_path_get(path, sizeof(path), CELL_METRICS_CACHE)))
+		return;
+
+	/* There is no cache until eovim exits for the first time */
+	Eina_File *const file = eina_file_open(path, EINA_FALSE);
+	if (!file)
+		return;
+	const char *const data = eina_file_map_all(file, EINA_FILE_SEQUENTIAL);
+	if (EINA_UNLIKELY(!data)) {
+		ERR("Failed to map '%s'", path);
+		goto close;
+	}
+
+	/* [version, fontconfig stamp, [[key, w, h, line_h]...]] */
+	msgpack_unpacked result;
+	msgpack_unpacked_init(&result);
+	size_t offset = 0u;
+	if (EINA_UNLIKELY(msgpack_unpack_next(&result, data, eina_file_size_get(file), &offset) !=
+			  MSGPACK_UNPACK_SUCCESS))
+		goto invalid;
+	const msgpack_object *const obj = &(result.data);
+	if (EINA_UNLIKELY((obj->type != MSGPACK_OBJECT_ARRAY) || (obj->via.array.size != 3u)))
+		goto invalid;
+	const msgpack_object *const args = obj->via.array.ptr;
+	if ((args[0].type != MSGPACK_OBJECT_POSITIVE_INTEGER) ||
+	    (args[0].via.u64 != CELL_METRICS_VERSION) ||
+	    (args[1].type != MSGPACK_OBJECT_POSITIVE_INTEGER) ||
+	    ((long long)args[1].via.u64 != _fontconfig_stamp_get())) {
+		INF("The cell metrics in '%s' are outdated", path);
+		_cell_metrics_changed = EINA_TRUE;
+		goto end;
+	}
+	if (EINA_UNLIKELY(args[2].type != MSGPACK_OBJECT_ARRAY))
+		goto invalid;
+
+	const msgpack_object_array *const entries = &(args[2].via.array);
+	for (uint32_t i = 0u; i < entries->size; i++) {
+		const msgpack_object *const entry = &(entries->ptr[i]);
+		if (EINA_UNLIKELY((entry->type != MSGPACK_OBJECT_ARRAY) ||
+				  (entry->via.array.size != 4u)))
+			goto invalid;
+		const msgpack_object *const e = entry->via.array.ptr;
+		if (EINA_UNLIKELY((e[0].type != MSGPACK_OBJECT_STR) ||
+				  (e[1].type != MSGPACK_OBJECT_POSITIVE_INTEGER) ||
+				  (e[2].type != MSGPACK_OBJECT_POSITIVE_INTEGER) ||
+				  (e[3].type != MSGPACK_OBJECT_POSITIVE_INTEGER) ||
+				  (e[1].via.u64 > UINT16_MAX) || (e[2].via.u64 > UINT16_MAX) ||
+				  (e[3].via.u64 > UINT16_MAX)))
+			goto invalid;
+
+		const msgpack_object_str *const str = &(e[0].via.str);
+		Eina_Stringshare *const key = eina_stringshare_add_length(str->ptr, str->size);
+		if (EINA_UNLIKELY(!key)) {
+			CRI("Failed to create stringshare");
+			goto end;
+		}
+		struct cell_metrics *const metrics = malloc(sizeof(struct cell_metrics));
+		if (EINA_UNLIKELY(!metrics)) {
+			CRI("Failed to allocate memory");
+			eina_stringshare_del(key);
+			goto end;
+		}
+		metrics->w = (unsigned int)e[1].via.u64;
+		metrics->h = (unsigned int)e[2].via.u64;
+		metrics->line_h = (unsigned int)e[3].via.u64;
+		if (EINA_UNLIKELY(!eina_hash_add(_cell_metrics, key, metrics))) {
+			ERR("Failed to add cell metrics to hash table");
+			free(metrics);
+		}
+		eina_stringshare_del(key);
+	}
+	DBG("Loaded %u cell metrics from '%s'", entries->size, path);
+	goto end;
+
+invalid:
+	WRN("The cell metrics in '%s' are invalid", path);
+	_cell_metrics_changed = EINA_TRUE;
+end:
+	msgpack_unpacked_destroy(&result);
+	eina_file_map_free(file, (void *)data);
+close:
+	eina_file_close(file);
+}
+
+static Eina_Bool _cell_metrics_pack_cb(const Eina_Hash *const hash EINA_UNUSED,
+				       const void *const key, void *const data, void *const fdata)
+{
+	const struct cell_metrics *const metrics = data;
+	msgpack_packer *const pk = fdata;
+
+	msgpack_pack_array(pk, 4);
+	msgpack_pack_str_with_body(pk, key, strlen(key));
+	msgpack_pack_uint32(pk, metrics->w);
+	msgpack_pack_uint32(pk, metrics->h);
+	msgpack_pack_uint32(pk, metrics->line_h);
+	return EINA_TRUE;
+}
+
+static void _cell_metrics_save(void)
+{
+	char path[PATH_MAX];
+	if (EINA_UNLIKELY(!cache_path_get(path, sizeof(path), CELL_METRICS_CACHE)))
+		return;
+
+	msgpack_sbuffer sbuf;
+	msgpack_packer pk;
+	msgpack_sbuffer_init(&sbuf);
+	msgpack_packer_init(&pk, &sbuf, msgpack_sbuffer_write);
+	msgpack_pack_array(&pk, 3);
+	msgpack_pack_uint32(&pk, CELL_METRICS_VERSION);
+	msgpack_pack_int64(&pk, _fontconfig_stamp_get());
+	msgpack_pack_array(&pk, (size_t)eina_hash_population(_cell_metrics));
+	eina_hash_foreach(_cell_metrics, &_cell_metrics_pack_cb, &pk);
+	cache_write(path, &sbuf);
+	msgpack_sbuffer_destroy(&sbuf);
+}
+
 Eina_Bool termview_init(void)
 {
 	static Evas_Smart_Class sc;
@@ -809,11 +1236,34 @@ Eina_Bool termview_init(void)
 	sc.resize = _smart_resize;
 	sc.callbacks = smart_callbacks, _smart = evas_smart_class_new(&sc);
 
+	_cell_metrics = eina_hash_string_superfast_new(&free);
+	if (EINA_UNLIKELY(!_cell_metrics)) {
+		CRI("Failed to create hash table");
+		evas_smart_free(_smart);
+		return EINA_FALSE;
+	}
+	_cell_metrics_load();
+
+	/* The keys are looked up by their names: the hash owns a copy of them */
+	_compose_starters = eina_hash_string_superfast_new(NULL);
+	if (EINA_UNLIKELY(!_compose_starters)) {
+		CRI("Failed to create hash table");
+		eina_hash_free(_cell_metrics);
+		_cell_metrics = NULL;
+		evas_smart_free(_smart);
+		return EINA_FALSE;
+	}
 	return EINA_TRUE;
 }
 
 void termview_shutdown(void)
 {
+	if (_cell_metrics_changed)
+		_cell_metrics_save();
+	eina_hash_free(_cell_metrics);
+	_cell_metrics = NULL;
+	eina_hash_free(_compose_starters);
+	_compose_starters = NULL;
 	evas_smart_free(_smart);
 }
 
@@ -824,7 +1274,12 @@ Evas_Object *termview_add(Evas_Object *parent, struct nvim *nvim)
 	struct termview *const sd = evas_object_smart_data_get(obj);
 	sd->object = obj;
 	sd->nvim = nvim;
+	sd->grid = nvim->grid;
 	sd->layout = parent;
+
+	/* We render the grid. Neovim does not draw anything before the UI is
+	 * attached, so we are registered before the grid is ever modified */
+	grid_backend_set(sd->grid, &_grid_backend, sd);
 	return obj;
 }
 
@@ -837,6 +1292,12 @@ void termview_cell_size_get(const Evas_Object *obj, unsigned int *w, unsigned in
 		*h = sd->cell_h;
 }
 
+const Evas_Textblock_Style *termview_textblock_style_get(const Evas_Object *obj)
+{
+	const struct termview *const sd = evas_object_smart_data_get(obj);
+	return sd->style.object;
+}
+
 void termview_size_get(const Evas_Object *obj, unsigned int *cols, unsigned int *rows)
 {
 	struct termview *const sd = evas_object_smart_data_get(obj);
@@ -846,36 +1307,41 @@ void termview_size_get(const Evas_Object *obj, unsigned int *cols, unsigned int
 		*rows = sd->rows;
 }
 
-void termview_matrix_set(Evas_Object *const obj, const unsigned int cols, const unsigned int rows)
+static void _textblock_clear(struct termview *const sd)
 {
-	EINA_SAFETY_ON_TRUE_RETURN((cols == 0) || (rows == 0));
-	struct termview *const sd = evas_object_smart_data_get(obj);
+	/* Delete everything written in the textblock */
+	evas_object_textblock_clear(sd->textblock);
+	sd->cursor.sep_written = EINA_FALSE;
+	memset(sd->markup_sizes, 0, sizeof(size_t) * sd->rows);
+	sd->markup_size = 0u;
 
-	/* Prevent useless resize */
-	if ((sd->cols == cols) && (sd->rows == rows)) {
-		return;
-	}
+	/* We add paragraph separators (<ps>) for each line. This allows a much
+	 * faster textblock lookup. We add an extra space before to avoid internal
+	 * textblock errors (is this a bug?) */
+	for (unsigned int i = 0u; i < sd->rows; i++)
+		evas_object_textblock_text_markup_prepend(sd->cursors[0], " </ps>");
 
-	/* We maintain the grid of cells as an Iliffe vector. Make sure we properly
-   * resize it without losing allocated memory */
-	if (sd->cells) {
-		free(sd->cells[0]);
-	}
-	sd->cells = realloc(sd->cells, rows * sizeof(struct cell *));
-	sd->cells[0] = malloc(rows * cols * sizeof(struct cell));
-	for (unsigned int i = 1; i < rows; i++) {
-		sd->cells[i] = sd->cells[i - 1] + cols;
+	/* One cursor per paragraph */
+	evas_textblock_cursor_paragraph_first(sd->cursors[0]);
+	for (unsigned int i = 1u; i < sd->rows; i++) {
+		evas_textblock_cursor_copy(sd->cursors[i - 1], sd->cursors[i]);
+		evas_textblock_cursor_paragraph_next(sd->cursors[i]);
 	}
+}
 
-	/* Every cell contains a single whitespace */
-	for (unsigned int i = 0; i < rows; i++) {
-		for (unsigned int j = 0; j < cols; j++) {
-			struct cell *const c = &sd->cells[i][j];
-			c->utf8[0] = ' ';
-			c->bytes = 1;
-			c->style_id = 0;
-		}
+static void _grid_resized_cb(void *const data, const unsigned int cols, const unsigned int rows)
+{
+	struct termview *const sd = data;
+
+	/* The markup sizes are resized first: if this fails, the termview keeps
+	 * its previous size and the rows it does not have are not drawn */
+	size_t *const markup_sizes = realloc(sd->markup_sizes, rows * sizeof(size_t));
+	if (EINA_UNLIKELY((markup_sizes == NULL) && (rows != 0u))) {
+		CRI("Failed to allocate memory");
+		sd->in_resize--;
+		return;
 	}
+	sd->markup_sizes = markup_sizes;
 
 	/* We maintain a table of cursors, one by line. */
 	if ((sd->cursors) && (rows < sd->rows)) {
@@ -888,136 +1354,166 @@ void termview_matrix_set(Evas_Object *const obj, const unsigned int cols, const
 		sd->cursors[i] = evas_object_textblock_cursor_new(sd->textblock);
 	}
 
-	/* Make sure our set of changed line has the right size. We don't care
-   * about its values, as we call termview_clear() just after */
-	sd->line_has_changed = realloc(sd->line_has_changed, sizeof(Eina_Bool) * rows);
-
 	sd->cols = cols;
 	sd->rows = rows;
-	termview_clear(obj);
+	_textblock_clear(sd);
 
 	sd->in_resize--;
 	sd->may_send_relayout = sd->in_resize == 0;
 }
 
-void termview_clear(Evas_Object *const obj)
+static void _grid_cleared_cb(void *const data)
 {
-	struct termview *const sd = evas_object_smart_data_get(obj);
-	EINA_SAFETY_ON_FALSE_RETURN(sd->cols != 0 && sd->rows != 0);
-
-	/* Delete everything written in the textblock */
-	evas_object_textblock_clear(sd->textblock);
-	sd->cursor.sep_written = EINA_FALSE;
-
-	/* Write ones everywhere. All lines do change. */
-	memset(sd->line_has_changed, 0xff, sizeof(Eina_Bool) * sd->rows);
+	_textblock_clear(data);
+}
 
-	/* We add paragraph separators (<ps>) for each line. This allows a much
-   * faster textblock lookup. We add an extra space before to avoid internal
-   * textblock errors (is this a bug?) */
-	for (unsigned int i = 0u; i < sd->rows; i++)
-		evas_object_textblock_text_markup_prepend(sd->cursors[0], " </ps>");
+static void _grid_styles_changed_cb(void *const data)
+{
+	struct termview *const sd = data;
+	sd->pending_style_update = EINA_TRUE;
+}
 
-	/* One cursor per paragraph */
-	evas_textblock_cursor_paragraph_first(sd->cursors[0]);
-	for (unsigned int i = 1u; i < sd->rows; i++) {
-		evas_textblock_cursor_copy(sd->cursors[i - 1], sd->cursors[i]);
-		evas_textblock_cursor_paragraph_next(sd->cursors[i]);
+static void _cell_markup_append(Eina_Strbuf *const line, const struct grid_cell *const c)
+{
+	/* The grid holds raw text, but the textblock expects markup */
+	if (c->bytes == 1) {
+		switch (c->utf8[0]) {
+		case '<':
+			eina_strbuf_append_length(line, "&lt;", 4);
+			return;
+		case '>':
+			eina_strbuf_append_length(line, "&gt;", 4);
+			return;
+		case '&':
+			eina_strbuf_append_length(line, "&amp;", 5);
+			return;
+		case '"':
+			eina_strbuf_append_length(line, "&quot;", 6);
+			return;
+		case '\'':
+			eina_strbuf_append_length(line, "&apos;", 6);
+			return;
+		}
 	}
+	eina_strbuf_append_length(line, c->utf8, c->bytes);
 }
 
-void termview_line_edit(Evas_Object *const obj, const unsigned int row, const unsigned int col,
-			const char *text, size_t text_len, const t_int style_id,
-			const size_t repeat)
+static void _grid_row_draw_cb(void *const data, const unsigned int row,
+			      const struct grid_cell *const cells, const unsigned int cols)
 {
-	struct termview *const sd = evas_object_smart_data_get(obj);
-	struct cell *const cells_row = sd->cells[row];
-	for (size_t i = 0; i < repeat; i++) {
-		struct cell *const c = &cells_row[col + i];
-		if (text_len == 1) {
-			switch (text[0]) {
-			case '<':
-				text = "&lt;";
-				text_len = 4;
-				break;
-
-			case '>':
-				text = "&gt;";
-				text_len = 4;
-				break;
-
-			case '&':
-				text = "&amp;";
-				text_len = 5;
-				break;
-
-			case '"':
-				text = "&quot;";
-				text_len = 6;
-				break;
-
-			case '\'':
-				text = "&apos;";
-				text_len = 6;
-				break;
+	struct termview *const sd = data;
+	Eina_Strbuf *const line = sd->line;
+
+	if (EINA_UNLIKELY(row >= sd->rows))
+		return;
+	if (sd->cursor.y == row)
+		sd->cursor.sep_written = EINA_FALSE;
+
+	uint32_t last_style = 0;
+	for (unsigned int col = 0u; col < cols; col++) {
+		const struct grid_cell *const c = &cells[col];
+
+		if (c->style_id != last_style) {
+			if (last_style != 0) {
+				eina_strbuf_append_printf(line, "</X%" PRIx32 ">", last_style);
+			}
+			if (c->style_id != 0) {
+				eina_strbuf_append_printf(line, "<X%" PRIx32 ">", c->style_id);
 			}
 		}
-		assert(text_len <= sizeof(c->utf8));
-		memcpy(c->utf8, text, text_len);
-		c->bytes = (uint32_t)text_len;
-		c->style_id = (uint32_t)style_id;
+
+		_cell_markup_append(line, c);
+		last_style = c->style_id;
 	}
-	sd->line_has_changed[row] = EINA_TRUE;
+	if (last_style != 0)
+		eina_strbuf_append_printf(line, "</X%" PRIx32 ">", last_style);
+
+	Evas_Textblock_Cursor *const start = sd->cursors[row];
+	Evas_Textblock_Cursor *const end = sd->tmp;
+	evas_textblock_cursor_copy(start, end);
+	evas_textblock_cursor_paragraph_char_first(start);
+	evas_textblock_cursor_paragraph_char_last(end);
+
+	evas_textblock_cursor_range_delete(start, end);
+	evas_object_textblock_text_markup_prepend(end, eina_strbuf_string_get(line));
+
+	const size_t markup_size = eina_strbuf_length_get(line);
+	sd->markup_size += markup_size - sd->markup_sizes[row];
+	sd->markup_sizes[row] = markup_size;
+	eina_strbuf_reset(line);
 }
 
+static const struct grid_backend _grid_backend = {
+	.resized = &_grid_resized_cb,
+	.cleared = &_grid_cleared_cb,
+	.styles_changed = &_grid_styles_changed_cb,
+	.row_draw = &_grid_row_draw_cb,
+};
+
 void termview_flush(Evas_Object *const obj)
 {
 	struct termview *const sd = evas_object_smart_data_get(obj);
-	Eina_Strbuf *const line = sd->line;
+	const double flush_start = ecore_time_get();
+
+	bench_mark(BENCH_STAGE_FIRST_FLUSH);
 
 	if (sd->pending_style_update)
 		termview_style_update(obj);
 
-	for (unsigned int i = 0u; i < sd->rows; i++) {
-		if (!sd->line_has_changed[i])
-			continue;
-		const struct cell *const row = sd->cells[i];
-
-		if (sd->cursor.y == i)
-			sd->cursor.sep_written = EINA_FALSE;
-
-		uint32_t last_style = 0;
-		for (unsigned int col = 0u; col < sd->cols; col++) {
-			const struct cell *const c = &row[col];
-
-			if (c->style_id != last_style) {
-				if (last_style != 0) {
-					eina_strbuf_append_printf(line, "</X%" PRIx32 ">",
-								  last_style);
-				}
-				if (c->style_id != 0) {
-					eina_strbuf_append_printf(line, "<X%" PRIx32 ">",
-								  c->style_id);
-				}
-			}
+	/* Typed characters that neovim did not echo yet are drawn again */
+	grid_predictions_reconcile(sd->grid);
+	const unsigned int dirty_rows = grid_flush(sd->grid);
+	mem_usage_update(MEM_POOL_TEXTBLOCK, &sd->markup_mem, sd->markup_size);
+	journal_drawn(sd->nvim->journal);
+
+	/* Auto-repeated keys are not held back anymore, and the mouse motion
+	 * accumulated since the last input can be sent */
+	sd->input.redraw_pending = EINA_FALSE;
+	if (_motion_pending_is(sd))
+		_input_job_ensure(sd);
+
+	/* Neovim's first frame is drawn in a single pass: it replaces the
+	 * snapshot at once */
+	if (sd->placeholder) {
+		evas_object_color_set(obj, 255, 255, 255, 255);
+		sd->placeholder = EINA_FALSE;
+	}
 
-			eina_strbuf_append_length(line, c->utf8, c->bytes);
-			last_style = c->style_id;
-		}
-		if (last_style != 0)
-			eina_strbuf_append_printf(line, "</X%" PRIx32 ">", last_style);
-
-		Evas_Textblock_Cursor *const start = sd->cursors[i];
-		Evas_Textblock_Cursor *const end = sd->tmp;
-		evas_textblock_cursor_copy(start, end);
-		evas_textblock_cursor_paragraph_char_first(start);
-		evas_textblock_cursor_paragraph_char_last(end);
-
-		evas_textblock_cursor_range_delete(start, end);
-		evas_object_textblock_text_markup_prepend(end, eina_strbuf_string_get(line));
-		eina_strbuf_reset(line);
+	struct gui *const gui = &sd->nvim->gui;
+	gui->stats.flushes++;
+	gui->stats.dirty_rows += dirty_rows;
+	const double flush_duration = ecore_time_get() - flush_start;
+	gui->stats.flush_time += flush_duration;
+	if (flush_duration > gui->stats.flush_max)
+		gui->stats.flush_max = flush_duration;
+}
+
+void termview_input_flush(Evas_Object *const obj)
+{
+	struct termview *const sd = evas_object_smart_data_get(obj);
+
+	/* Send right away what waits for the end of the iteration. The motion
+	 * held until neovim redraws is still held */
+	if (sd->input.job) {
+		ecore_job_del(sd->input.job);
+		_input_flush_cb(sd);
 	}
-	memset(sd->line_has_changed, 0, sizeof(Eina_Bool) * sd->rows);
+}
+
+void termview_placeholder_show(Evas_Object *const obj)
+{
+	struct termview *const sd = evas_object_smart_data_get(obj);
+
+	/* The snapshot has the dimensions neovim is attached with: there is no
+	 * need to ask neovim to resize */
+	sd->need_nvim_resize = EINA_FALSE;
+	termview_style_update(obj);
+	grid_flush(sd->grid);
+	mem_usage_update(MEM_POOL_TEXTBLOCK, &sd->markup_mem, sd->markup_size);
+
+	/* Colors of smart members are multiplied by the ones of the smart object */
+	evas_object_color_set(obj, 160, 160, 160, 255);
+	sd->placeholder = EINA_TRUE;
 }
 
 /**
@@ -1030,8 +1526,8 @@ void termview_redraw_end(Evas_Object *const obj)
 {
 	struct termview *const sd = evas_object_smart_data_get(obj);
 
-	const unsigned int to_x = sd->cursor.next_x;
-	const unsigned int to_y = sd->cursor.next_y;
+	const unsigned int to_x = sd->grid->cursor.x;
+	const unsigned int to_y = sd->grid->cursor.y;
 
 	/* Avoid useless computations */
 	if ((to_x == sd->cursor.x) && (to_y == sd->cursor.y) && (!sd->mode_changed))
@@ -1102,87 +1598,6 @@ void termview_redraw_end(Evas_Object *const obj)
 	sd->mode_changed = EINA_FALSE;
 }
 
-void termview_cursor_goto(Evas_Object *const obj, const unsigned int to_x, const unsigned int to_y)
-{
-	struct termview *const sd = evas_object_smart_data_get(obj);
-	EINA_SAFETY_ON_FALSE_RETURN(to_y < sd->rows);
-	EINA_SAFETY_ON_FALSE_RETURN(sd->cols != 0 && sd->rows != 0);
-
-	sd->cursor.next_x = to_x;
-	sd->cursor.next_y = to_y;
-}
-
-void termview_scroll(Evas_Object *const obj, const int top, const int bot, const int left,
-		     const int right, const int rows)
-{
-	struct termview *const sd = evas_object_smart_data_get(obj);
-	EINA_SAFETY_ON_FALSE_RETURN(right > left);
-	EINA_SAFETY_ON_FALSE_RETURN(top >= 0 && bot >= 0 && left >= 0);
-
-	int start_line, end_line, step;
-	if (rows > 0) {
-		/* Here, we scroll text UPWARDS. Line N-1 is replaced by line N.
-		 *
-		 *
-		 * top
-		 *   '>+------------------+     +------------------+
-		 *     | Line 0           |  ,> | Line 1           |
-		 *     +------------------+ /   +------------------+
-		 * (1) | Line 1           |' ,> | Line 2           |
-		 *     +------------------+ /   +------------------+
-		 * (2) | Line 2           |'    | xxxxxx           |
-		 *  ,> +------------------+     +------------------+
-		 * bot
-		 *
-		 * So we start at top+|rows|, because top replaces nothing.
-		 *     top+rows will overwrite top.
-		 *     top+rows+1 will overwrite top+rows+1
-		 *     etc.
-		 *
-		 * One bot is reached (exclusive), we are done.
-		 */
-		start_line = top + rows;
-		end_line = bot;
-		step = +1;
-	} else {
-		/* Here, we scroll text DOWNWARDS. Line N+1 is replaced by line N.
-		 *
-		 *     +------------------+     +------------------+
-		 * (2) | Line 0           |,    | xxxxxx           |
-		 *     +------------------+ \   +------------------+
-		 * (1) | Line 1           |, '> | Line 0           |
-		 *     +------------------+ \   +------------------+
-		 *     | Line 2           |  '> | Line 1           |
-		 *     +------------------+     +------------------+
-		 *
-		 * We start at bot-1-|rows|
-		 */
-		assert(rows < 0); /* <--- Frienly reminder */
-		start_line = bot - 1 + rows;
-		end_line = top - 1; /* Make the range exclusive */
-		step = -1;
-	}
-
-	/* We have four working cursors
-	 * c1 and c2 delimit the line portion to be copied
-	 * c3 and c4 delimit the line portion to be replaced
-	 */
-	for (int from_line = start_line; from_line != end_line; from_line += step) {
-		const int to_line = from_line - rows;
-		if ((unsigned int)to_line >= sd->rows) {
-			continue;
-		}
-
-		const struct cell *const source_row = sd->cells[from_line];
-		struct cell *const target_row = sd->cells[to_line];
-
-		const size_t len = sizeof(struct cell) * (size_t)(right - left);
-		memcpy(&target_row[left], &source_row[left], len);
-
-		sd->line_has_changed[to_line] = EINA_TRUE;
-	}
-}
-
 void termview_cell_geometry_get(const Evas_Object *const obj, const unsigned int cell_x,
 				const unsigned int cell_y, int *const px, int *const py,
 				int *const pw, int *const ph)
@@ -1206,52 +1621,53 @@ void termview_cursor_mode_set(Evas_Object *const obj, const struct mode *const m
 	cursor_mode_set(gui->cursor, mode);
 
 	/* Update the cursor's color settings **************************************/
-	struct termview_style *const style = eina_hash_find(sd->styles, &mode->attr_id);
+	const struct grid_style *const style = grid_style_find(sd->grid, mode->attr_id);
 	if (style != NULL)
 		cursor_color_set(gui->cursor, style->fg_color);
 
 	/* Register the new mode and update the cursor calculation function. */
 	sd->mode_changed = EINA_TRUE;
-}
 
-void termview_default_colors_set(Evas_Object *const obj, const union color fg, const union color bg,
-				 const union color sp)
-{
-	struct termview *const sd = evas_object_smart_data_get(obj);
-	const Eina_Bool changed = (sd->style.default_fg.value != fg.value) ||
-				  (sd->style.default_bg.value != bg.value) ||
-				  (sd->style.default_sp.value != sp.value);
-
-	if (changed) {
-		sd->style.default_fg = fg;
-		sd->style.default_bg = bg;
-		sd->style.default_sp = sp;
-		sd->pending_style_update = EINA_TRUE;
-	}
+	/* Typed characters are only predicted in insert mode */
+	sd->insert_mode = mode->short_name && !strcmp(mode->short_name, "i");
+	if (!sd->insert_mode)
+		grid_predictions_drop(sd->grid);
 }
 
-struct termview_style *termview_style_get(Evas_Object *const obj, const t_int style_id)
+static struct cell_metrics *_cell_metrics_get(const struct termview *const sd)
 {
-	struct termview *const sd = evas_object_smart_data_get(obj);
-	struct termview_style *style = eina_hash_find(sd->styles, &style_id);
-	if (style == NULL) {
-		style = _termview_style_new();
-		if (EINA_UNLIKELY(!style))
-			return NULL;
-		const Eina_Bool added = eina_hash_add(sd->styles, &style_id, style);
-		if (EINA_UNLIKELY(!added)) {
-			ERR("Failed to add style to hash table");
-			_termview_style_free(style);
-			return NULL;
-		}
+	/* The font name has no length limit, so the key is sized from it */
+	Eina_Stringshare *const key =
+		eina_stringshare_printf("%s:%u:%u:%.3f", sd->style.font_name, sd->style.font_size,
+					sd->style.line_gap, elm_config_scale_get());
+	if (EINA_UNLIKELY(!key)) {
+		CRI("Failed to create stringshare");
+		return NULL;
 	}
-	return style;
-}
 
-void termview_style_changed(Evas_Object *const obj)
-{
-	struct termview *const sd = evas_object_smart_data_get(obj);
-	sd->pending_style_update = EINA_TRUE;
+	struct cell_metrics *metrics = eina_hash_find(_cell_metrics, key);
+	if (metrics)
+		goto end;
+
+	metrics = calloc(1, sizeof(struct cell_metrics));
+	if (EINA_UNLIKELY(!metrics)) {
+		CRI("Failed to allocate memory");
+		goto end;
+	}
+	evas_object_textgrid_font_set(sd->sizing_textgrid, sd->style.font_name,
+				      (int)sd->style.font_size);
+	evas_object_textgrid_cell_size_get(sd->sizing_textgrid, (int *)&metrics->w,
+					   (int *)&metrics->h);
+	if (EINA_UNLIKELY(!eina_hash_add(_cell_metrics, key, metrics))) {
+		ERR("Failed to add cell metrics to hash table");
+		free(metrics);
+		metrics = NULL;
+		goto end;
+	}
+	_cell_metrics_changed = EINA_TRUE;
+end:
+	eina_stringshare_del(key);
+	return metrics;
 }
 
 void termview_font_set(Evas_Object *const obj, Eina_Stringshare *const font_name,
@@ -1264,10 +1680,11 @@ void termview_font_set(Evas_Object *const obj, Eina_Stringshare *const font_name
 	eina_stringshare_replace(&sd->style.font_name, font_name);
 	sd->style.font_size = font_size;
 
-	evas_object_textgrid_font_set(sd->sizing_textgrid, sd->style.font_name,
-				      (int)sd->style.font_size);
-	evas_object_textgrid_cell_size_get(sd->sizing_textgrid, (int *)&sd->cell_w,
-					   (int *)&sd->cell_h);
+	const struct cell_metrics *const metrics = _cell_metrics_get(sd);
+	if (EINA_LIKELY(metrics != NULL)) {
+		sd->cell_w = metrics->w;
+		sd->cell_h = (metrics->line_h) ? metrics->line_h : metrics->h;
+	}
 	sd->need_nvim_resize = (old_cell_w != sd->cell_w) || (old_cell_h != sd->cell_h);
 	sd->pending_style_update = EINA_TRUE;
 }
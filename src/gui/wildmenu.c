@@ -2,6 +2,7 @@
 
 #include <eovim/gui.h>
 #include <eovim/log.h>
+#include <eovim/mem.h>
 
 #include "gui_private.h"
 
@@ -33,12 +34,26 @@ static Evas_Object *wildmenu_resuable_content_get(void *const data, Evas_Object
 static void wildmenu_item_del(void *const data, Evas_Object *const obj EINA_UNUSED)
 {
 	Eina_Stringshare *const item = data;
+	mem_free_account(MEM_POOL_WILDMENU, (size_t)eina_stringshare_strlen(item) + 1u);
 	eina_stringshare_del(item);
 }
 
+struct wildmenu *gui_wildmenu_get(struct gui *const gui)
+{
+	/* The wildmenu is only created when it is first used */
+	if (!gui->wildmenu)
+		gui->wildmenu = gui_wildmenu_add(gui);
+	return gui->wildmenu;
+}
+
 void gui_wildmenu_append(struct gui *const gui, Eina_Stringshare *const item)
 {
-	struct wildmenu *const wm = gui->wildmenu;
+	struct wildmenu *const wm = gui_wildmenu_get(gui);
+	if (EINA_UNLIKELY(!wm)) {
+		eina_stringshare_del(item);
+		return;
+	}
+	mem_alloc_account(MEM_POOL_WILDMENU, (size_t)eina_stringshare_strlen(item) + 1u);
 	popupmenu_append(&wm->pop, (void *)item);
 }
 
@@ -59,7 +74,9 @@ static void wildmenu_resize(struct popupmenu *const pop)
 
 void gui_wildmenu_show(struct gui *const gui, const unsigned int pos EINA_UNUSED)
 {
-	struct wildmenu *const wm = gui->wildmenu;
+	struct wildmenu *const wm = gui_wildmenu_get(gui);
+	if (EINA_UNLIKELY(!wm))
+		return;
 	struct popupmenu *const pop = &wm->pop;
 	gui->active_popup = pop;
 
@@ -91,14 +108,18 @@ struct wildmenu *gui_wildmenu_add(struct gui *const gui)
 
 void gui_wildmenu_del(struct wildmenu *const wm)
 {
-	popupmenu_del(&wm->pop);
-	free(wm);
+	if (wm) {
+		popupmenu_del(&wm->pop);
+		free(wm);
+	}
 }
 
 void gui_wildmenu_style_set(struct wildmenu *const wm, const Evas_Textblock_Style *const style,
 			    const unsigned int cell_w, const unsigned int cell_h)
 {
-	popupmenu_style_changed(&wm->pop, style, cell_w, cell_h);
+	/* A wildmenu that is not created yet gets the style on creation */
+	if (wm)
+		popupmenu_style_changed(&wm->pop, style, cell_w, cell_h);
 }
 
 Eina_Bool gui_wildmenu_init(void)
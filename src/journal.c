@@ -0,0 +1,390 @@
+/* This file is part of Eovim, which is under the MIT License ****************/
+
+#include "eovim/journal.h"
+#include "eovim/nvim.h"
+#include "eovim/nvim_request.h"
+#include "eovim/log.h"
+
+#include <signal.h>
+#include <unistd.h>
+
+/* Inputs longer than this are truncated. They are only meant to be
+ * recognized */
+#define JOURNAL_INPUT_MAX 23u
+
+struct journal_entry {
+	double received_at;
+	double sent_at; /**< 0.0 until sent */
+	double answered_at; /**< 0.0 until answered */
+	double drawn_at; /**< 0.0 until drawn */
+	uint32_t req_id;
+	enum journal_kind kind;
+	Eina_Bool dropped;
+	unsigned char size;
+	char input[JOURNAL_INPUT_MAX];
+};
+
+struct journal {
+	EINA_INLIST; /**< All the journals are dumped on crash */
+	struct journal_entry entries[JOURNAL_SIZE];
+	unsigned int next; /**< Entry to be written next */
+	unsigned int count; /**< Count of entries written, up to JOURNAL_SIZE */
+
+	/* Count of entries waiting for each stage. The journal is only searched
+	 * while some are */
+	unsigned int unsent;
+	unsigned int unanswered;
+	unsigned int undrawn;
+
+	uint32_t last_sent[__JOURNAL_KIND_LAST]; /**< Last request of each kind */
+};
+
+static const char *const _kind_names[__JOURNAL_KIND_LAST] = {
+	[JOURNAL_KIND_KEY] = "key",
+	[JOURNAL_KIND_MOUSE] = "mouse",
+	[JOURNAL_KIND_WHEEL] = "wheel",
+};
+
+/* Signals that are considered as crashes */
+static const int _signals[] = { SIGSEGV, SIGBUS, SIGILL, SIGFPE, SIGABRT };
+static struct sigaction _old_actions[EINA_C_ARRAY_LENGTH(_signals)];
+
+static Eina_Inlist *_journals = NULL;
+
+/* Index of the entry written @p age entries before the most recent one */
+static inline unsigned int _entry_index(const struct journal *const journal,
+					const unsigned int age)
+{
+	return (journal->next + JOURNAL_SIZE - 1u - age) % JOURNAL_SIZE;
+}
+
+/* Iterate over the entries of a journal, from the most recent to the oldest */
+#define JOURNAL_FOREACH_REVERSE(Journal, It, Entry)                                                \
+	for ((It) = 0u; ((It) < (Journal)->count) &&                                               \
+			((Entry) = &((Journal)->entries[_entry_index((Journal), (It))]));          \
+	     (It)++)
+
+static void _entry_forget(struct journal *const journal, const struct journal_entry *const entry)
+{
+	/* The entry is overwritten before reaching its last stage */
+	if (entry->dropped)
+		return;
+	if (entry->sent_at <= 0.0)
+		journal->unsent--;
+	else if (entry->answered_at <= 0.0)
+		journal->unanswered--;
+	else if (entry->drawn_at <= 0.0)
+		journal->undrawn--;
+}
+
+/* Entries are formatted by hand, with integer arithmetic only: snprintf() is
+ * not async-signal-safe, and the crash handler formats them too. One byte is
+ * always left for the trailing newline the crash handler adds */
+struct line {
+	char buf[256];
+	size_t len;
+};
+
+static void _line_append(struct line *const line, const char *const str, const size_t size)
+{
+	const size_t room = sizeof(line->buf) - 1u - line->len;
+	const size_t count = (size < room) ? size : room;
+	memcpy(line->buf + line->len, str, count);
+	line->len += count;
+}
+
+static inline void _line_str(struct line *const line, const char *const str)
+{
+	_line_append(line, str, strlen(str));
+}
+
+/* Pad @p line with spaces up to @p column */
+static void _line_pad(struct line *const line, const size_t column)
+{
+	while ((line->len < column) && (line->len < sizeof(line->buf) - 1u))
+		line->buf[line->len++] = ' ';
+}
+
+/* Append @p value in decimal, with at least @p digits digits */
+static void _line_uint(struct line *const line, uint64_t value, const unsigned int digits)
+{
+	char str[20];
+	unsigned int count = 0u;
+	do {
+		str[sizeof(str) - 1u - count++] = (char)('0' + (value % 10u));
+		value /= 10u;
+	} while ((value != 0u) || ((count < digits) && (count < sizeof(str))));
+	_line_append(line, str + sizeof(str) - count, count);
+}
+
+/* Append @p value with @p decimals (up to 3) digits after the point, right
+ * aligned on @p width characters */
+static void _line_fixed(struct line *const line, double value, const unsigned int decimals,
+			const size_t width)
+{
+	static const unsigned int scales[] = { 1u, 10u, 100u, 1000u };
+	const unsigned int scale = scales[decimals];
+	struct line number = { .len = 0u };
+
+	if (value < 0.0) {
+		_line_append(&number, "-", 1u);
+		value = -value;
+	}
+	const uint64_t scaled = (uint64_t)(value * scale + 0.5);
+	_line_uint(&number, scaled / scale, 1u);
+	if (decimals != 0u) {
+		_line_append(&number, ".", 1u);
+		_line_uint(&number, scaled % scale, decimals);
+	}
+	_line_pad(line, line->len + width - ((number.len < width) ? number.len : width));
+	_line_append(line, number.buf, number.len);
+}
+
+static void _stage_format(struct line *const line, const double from, const double to,
+			  const double now)
+{
+	/* A stage that is not reached yet tells how long it has been awaited */
+	if (from <= 0.0)
+		_line_str(line, "-");
+	else {
+		if (to <= 0.0)
+			_line_str(line, "> ");
+		_line_fixed(line, (((to <= 0.0) ? now : to) - from) * 1000.0, 1u, 0u);
+		_line_str(line, "ms");
+	}
+}
+
+/* Format @p entry in @p line. This can be called from the crash handler */
+static void _entry_format(const struct journal_entry *const entry, const double now,
+			  struct line *const line)
+{
+	line->len = 0u;
+	_line_fixed(line, now - entry->received_at, 3u, 9u);
+	_line_str(line, "s ago ");
+	size_t column = line->len;
+	_line_str(line, _kind_names[entry->kind]);
+	_line_pad(line, column + 5u);
+	_line_append(line, " ", 1u);
+	column = line->len;
+	_line_append(line, entry->input, entry->size);
+	_line_pad(line, column + JOURNAL_INPUT_MAX);
+	if (entry->dropped) {
+		_line_str(line, " dropped");
+		return;
+	}
+
+	_line_str(line, " #");
+	column = line->len;
+	_line_uint(line, entry->req_id, 1u);
+	_line_pad(line, column + 6u);
+	_line_str(line, " queued ");
+	_stage_format(line, entry->received_at, entry->sent_at, now);
+	_line_str(line, ", answered ");
+	_stage_format(line, entry->sent_at, entry->answered_at, now);
+	_line_str(line, ", drawn ");
+	_stage_format(line, entry->answered_at, entry->drawn_at, now);
+}
+
+static void _crash_cb(const int sig)
+{
+	struct line line = { .len = 0u };
+	const double now = ecore_time_get();
+	const struct journal *journal;
+
+	/* The handlers that were installed before ours (e.g. by the EFL) get the
+	 * signal, which is raised again once the journals are written: it stays
+	 * blocked until we return */
+	for (unsigned int i = 0u; i < EINA_C_ARRAY_LENGTH(_signals); i++) {
+		if (_signals[i] == sig)
+			sigaction(sig, &_old_actions[i], NULL);
+	}
+
+	_line_str(&line, "eovim: caught signal ");
+	_line_uint(&line, (uint64_t)sig, 1u);
+	_line_str(&line, ". Last inputs:\n");
+	if (write(STDERR_FILENO, line.buf, line.len) < 0)
+		goto end;
+	EINA_INLIST_FOREACH (_journals, journal) {
+		for (unsigned int n = journal->count; n > 0u; n--) {
+			const struct journal_entry *const entry =
+				&(journal->entries[_entry_index(journal, n - 1u)]);
+			_entry_format(entry, now, &line);
+			line.buf[line.len++] = '\n';
+			if (write(STDERR_FILENO, line.buf, line.len) < 0)
+				goto end;
+		}
+	}
+end:
+	raise(sig);
+}
+
+struct journal *journal_new(void)
+{
+	struct journal *const journal = calloc(1, sizeof(struct journal));
+	if (EINA_UNLIKELY(!journal)) {
+		CRI("Failed to allocate memory");
+		return NULL;
+	}
+	_journals = eina_inlist_append(_journals, EINA_INLIST_GET(journal));
+	return journal;
+}
+
+void journal_free(struct journal *const journal)
+{
+	if (journal) {
+		_journals = eina_inlist_remove(_journals, EINA_INLIST_GET(journal));
+		free(journal);
+	}
+}
+
+void journal_input_add(struct journal *const journal, const enum journal_kind kind,
+		       const char *const input, const size_t size, const Eina_Bool dropped)
+{
+	struct journal_entry *const entry = &(journal->entries[journal->next]);
+	if (journal->count == JOURNAL_SIZE)
+		_entry_forget(journal, entry);
+	else
+		journal->count++;
+	journal->next = (journal->next + 1u) % JOURNAL_SIZE;
+
+	memset(entry, 0, sizeof(*entry));
+	entry->received_at = ecore_time_get();
+	entry->kind = kind;
+	entry->dropped = dropped;
+	entry->size = (unsigned char)((size < JOURNAL_INPUT_MAX) ? size : JOURNAL_INPUT_MAX);
+	memcpy(entry->input, input, entry->size);
+	if (!dropped)
+		journal->unsent++;
+}
+
+void journal_sent(struct journal *const journal, const enum journal_kind kind,
+		  const uint32_t req_id)
+{
+	const double now = ecore_time_get();
+	const uint32_t previous = journal->last_sent[kind];
+	struct journal_entry *entry;
+	unsigned int it;
+	unsigned int sent = 0u;
+
+	journal->last_sent[kind] = req_id;
+	JOURNAL_FOREACH_REVERSE (journal, it, entry) {
+		if (journal->unsent == 0u)
+			break;
+		if (entry->dropped || (entry->sent_at > 0.0))
+			continue;
+		if (entry->kind == kind) {
+			entry->sent_at = now;
+			entry->req_id = req_id;
+			journal->unsent--;
+			journal->unanswered++;
+			sent++;
+		}
+	}
+	if (sent != 0u)
+		return;
+
+	/* A request that carries no new input continues the previous one of the
+	 * same kind (e.g. the steps of the wheel, sent one by one): its inputs
+	 * are answered with the last request */
+	unsigned int left = journal->unanswered;
+	JOURNAL_FOREACH_REVERSE (journal, it, entry) {
+		if (left == 0u)
+			break;
+		if ((entry->sent_at <= 0.0) || (entry->answered_at > 0.0))
+			continue;
+		left--;
+		if ((entry->kind == kind) && (entry->req_id == previous))
+			entry->req_id = req_id;
+	}
+}
+
+void journal_answered(struct journal *const journal, const uint32_t req_id)
+{
+	const double now = ecore_time_get();
+	struct journal_entry *entry;
+	unsigned int it;
+
+	/* Most responses are not for inputs */
+	unsigned int left = journal->unanswered;
+	JOURNAL_FOREACH_REVERSE (journal, it, entry) {
+		if (left == 0u)
+			break;
+		if ((entry->sent_at <= 0.0) || (entry->answered_at > 0.0))
+			continue;
+		left--;
+		if (entry->req_id == req_id) {
+			entry->answered_at = now;
+			journal->unanswered--;
+			journal->undrawn++;
+		}
+	}
+}
+
+void journal_drawn(struct journal *const journal)
+{
+	const double now = ecore_time_get();
+	struct journal_entry *entry;
+	unsigned int it;
+
+	JOURNAL_FOREACH_REVERSE (journal, it, entry) {
+		if (journal->undrawn == 0u)
+			break;
+		if ((entry->answered_at > 0.0) && (entry->drawn_at <= 0.0)) {
+			entry->drawn_at = now;
+			journal->undrawn--;
+		}
+	}
+}
+
+void journal_pack(const struct journal *const journal, msgpack_packer *const pk)
+{
+	const double now = ecore_time_get();
+	struct line line;
+
+	msgpack_pack_array(pk, journal->count);
+	for (unsigned int n = journal->count; n > 0u; n--) {
+		const struct journal_entry *const entry =
+			&(journal->entries[_entry_index(journal, n - 1u)]);
+		_entry_format(entry, now, &line);
+		msgpack_pack_str(pk, line.len);
+		msgpack_pack_str_body(pk, line.buf, line.len);
+	}
+}
+
+static Eina_Bool _journal_request_cb(struct nvim *const nvim,
+				     const msgpack_object_array *const args EINA_UNUSED,
+				     msgpack_packer *const pk, const uint32_t req_id)
+{
+	msgpack_pack_array(pk, 4);
+	msgpack_pack_int(pk, 1);
+	msgpack_pack_uint32(pk, req_id);
+	msgpack_pack_nil(pk); /* Error */
+	journal_pack(nvim->journal, pk); /* Result */
+	return nvim_flush(nvim);
+}
+
+Eina_Bool journal_init(void)
+{
+	struct sigaction action;
+
+	if (EINA_UNLIKELY(!nvim_request_add("journal", &_journal_request_cb)))
+		return EINA_FALSE;
+
+	memset(&action, 0, sizeof(action));
+	action.sa_handler = &_crash_cb;
+	action.sa_flags = 0;
+	sigemptyset(&action.sa_mask);
+	for (unsigned int i = 0u; i < EINA_C_ARRAY_LENGTH(_signals); i++) {
+		if (EINA_UNLIKELY(sigaction(_signals[i], &action, &_old_actions[i]) != 0))
+			WRN("Failed to handle signal %i. The journal will not be dumped on it",
+			    _signals[i]);
+	}
+	return EINA_TRUE;
+}
+
+void journal_shutdown(void)
+{
+	nvim_request_del("journal");
+	for (unsigned int i = 0u; i < EINA_C_ARRAY_LENGTH(_signals); i++)
+		sigaction(_signals[i], &_old_actions[i], NULL);
+}
@@ -0,0 +1,25 @@
+/* This file is part of Eovim, which is under the MIT License ****************/
+
+#ifndef __EOVIM_KEYMAP_HASH_H__
+#define __EOVIM_KEYMAP_HASH_H__
+
+#include <stdint.h>
+
+/*
+ * Hash function of the key translation tables. It is shared by keymap-gen,
+ * which searches for the seed that makes it collision-free over all the keys
+ * of src/keymap_keys.h, and by keymap_get().
+ */
+static inline uint32_t keymap_hash(const char *key, const uint32_t seed)
+{
+	/* FNV-1a, with a salted offset basis and a final mix of the high bits,
+	 * as only the low ones index the table */
+	uint32_t hash = 2166136261u ^ seed;
+	for (; *key != '\0'; key++) {
+		hash ^= (uint8_t)*key;
+		hash *= 16777619u;
+	}
+	return hash ^ (hash >> 16);
+}
+
+#endif /* ! __EOVIM_KEYMAP_HASH_H__ */
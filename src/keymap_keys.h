@@ -0,0 +1,67 @@
+/* This file is part of Eovim, which is under the MIT License ****************/
+
+/*
+ * Special keys, as named by Ecore (Ecore_Event_Key::key), and how neovim
+ * spells them. This list is expanded by keymap-gen, which generates the key
+ * translation tables at build time, and rejects duplicated keys:
+ *
+ *   - KM(Key, Std): the key Key is sent to neovim as <Std>;
+ *   - KM_IDENT(Key): the key Key is sent to neovim as <Key>;
+ *   - KM_CAPS_LOCK(Key): the key Key toggles the caps lock. It is not sent.
+ *
+ * This file has no include guards on purpose.
+ */
+
+KM_IDENT("Up")
+KM_IDENT("Down")
+KM_IDENT("Left")
+KM_IDENT("Right")
+KM_IDENT("F1")
+KM_IDENT("F2")
+KM_IDENT("F3")
+KM_IDENT("F4")
+KM_IDENT("F5")
+KM_IDENT("F6")
+KM_IDENT("F7")
+KM_IDENT("F8")
+KM_IDENT("F9")
+KM_IDENT("F10")
+KM_IDENT("F11")
+KM_IDENT("F12")
+KM_IDENT("F13")
+KM_IDENT("F14")
+KM_IDENT("F15")
+KM_IDENT("F16")
+KM_IDENT("F17")
+KM_IDENT("F18")
+KM_IDENT("F19")
+KM_IDENT("F20")
+KM_IDENT("F21")
+KM_IDENT("F22")
+KM_IDENT("F23")
+KM_IDENT("F24")
+KM_IDENT("F25")
+KM_IDENT("F26")
+KM_IDENT("F27")
+KM_IDENT("F28")
+KM_IDENT("F29")
+KM_IDENT("F30")
+KM_IDENT("F31")
+KM_IDENT("F32")
+KM_IDENT("F33")
+KM_IDENT("F34")
+KM_IDENT("F35")
+KM_IDENT("F36")
+KM_IDENT("F37")
+KM_IDENT("Home")
+KM_IDENT("End")
+KM("BackSpace", "BS")
+KM("less", "lt")
+KM("Prior", "PageUp")
+KM("Next", "PageDown")
+KM("Delete", "Del")
+KM("space", "Space")
+KM_IDENT("Tab")
+KM("ISO_Left_Tab", "Tab")
+KM("backslash", "Bslash")
+KM_CAPS_LOCK("Caps_Lock")
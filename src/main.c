@@ -1,19 +1,22 @@
 /* This file is part of Eovim, which is under the MIT License ****************/
 
-#include <eovim/keymap.h>
+#include <eovim/bench.h>
+#include <eovim/daemon.h>
+#include <eovim/mem.h>
 #include <eovim/nvim.h>
 #include <eovim/nvim_api.h>
 #include <eovim/version.h>
 #include <eovim/nvim_request.h>
 #include <eovim/nvim_event.h>
+#include <eovim/clipboard.h>
+#include <eovim/journal.h>
+#include <eovim/snapshot.h>
 #include <eovim/termview.h>
 #include <eovim/main.h>
 #include <eovim/log.h>
 
 #include <Ecore_Getopt.h>
 
-int _eovim_log_domain = -1;
-
 static Eina_Bool _in_tree = EINA_FALSE;
 static Eina_Strbuf *_edje_file = NULL;
 
@@ -29,8 +32,9 @@ static const struct module _modules[] = {
 		.name = #name_, .init = &name_##_init, .shutdown = &name_##_shutdown               \
 	}
 
-	MODULE(keymap),	      MODULE(nvim_api),	      MODULE(nvim_request), MODULE(nvim_event),
-	MODULE(gui_wildmenu), MODULE(gui_completion), MODULE(termview),
+	MODULE(nvim_api),       MODULE(nvim_request), MODULE(journal),
+	MODULE(nvim_event),     MODULE(clipboard),    MODULE(gui_wildmenu),
+	MODULE(gui_completion), MODULE(termview),
 
 #undef MODULE
 };
@@ -48,6 +52,16 @@ static const Ecore_Getopt options_desc = {
 	  ECORE_GETOPT_STORE_STR('t', "theme", "Path to the Edje theme"),
 	  ECORE_GETOPT_STORE_TRUE('M', "maximized", "Start eovim in a maximized window"),
 	  ECORE_GETOPT_STORE_TRUE('F', "fullscreen", "Start eovim in a fullscreen window"),
+	  ECORE_GETOPT_STORE_TRUE('\0', "bench-startup",
+				  "Print the time spent in each startup stage, then exit"),
+	  ECORE_GETOPT_STORE_TRUE('\0', "mem-report",
+				  "Print the memory used by each subsystem when exiting"),
+	  ECORE_GETOPT_STORE_TRUE('\0', "daemon",
+				  "Keep warm neovim instances, and open windows for the clients"),
+	  ECORE_GETOPT_STORE_TRUE('\0', "client",
+				  "Ask the eovim daemon to open the files, if it is running"),
+	  ECORE_GETOPT_STORE_TRUE('\0', "no-snapshot",
+				  "Neither show the last screen at startup, nor save it on exit"),
 	  ECORE_GETOPT_CALLBACK_ARGS(
 		  'g', "geometry",
 		  "Set the initial dimensions of the window (e.g. 120x40 for a 120x40 cells window)",
@@ -94,6 +108,7 @@ const char *main_edje_file_get(void)
  */
 static void __attribute__((constructor)) __constructor(void)
 {
+	bench_mark(BENCH_STAGE_PROCESS);
 	setenv("EINA_LOG_BACKTRACE", "-1", 0);
 	eina_log_domain_level_set("efreet_cache", 0);
 #ifdef NDEBUG
@@ -110,6 +125,11 @@ EAPI_MAIN int elm_main(int argc, char **argv)
 		.theme = "default",
 		.fullscreen = EINA_FALSE,
 		.maximized = EINA_FALSE,
+		.bench_startup = EINA_FALSE,
+		.mem_report = EINA_FALSE,
+		.daemon = EINA_FALSE,
+		.client = EINA_FALSE,
+		.no_snapshot = EINA_FALSE,
 	};
 	Eina_Bool quit = EINA_FALSE;
 	Eina_Bool version = EINA_FALSE;
@@ -117,6 +137,11 @@ EAPI_MAIN int elm_main(int argc, char **argv)
 					ECORE_GETOPT_VALUE_STR(opts.theme),
 					ECORE_GETOPT_VALUE_BOOL(opts.maximized),
 					ECORE_GETOPT_VALUE_BOOL(opts.fullscreen),
+					ECORE_GETOPT_VALUE_BOOL(opts.bench_startup),
+					ECORE_GETOPT_VALUE_BOOL(opts.mem_report),
+					ECORE_GETOPT_VALUE_BOOL(opts.daemon),
+					ECORE_GETOPT_VALUE_BOOL(opts.client),
+					ECORE_GETOPT_VALUE_BOOL(opts.no_snapshot),
 					ECORE_GETOPT_VALUE_PTR_CAST(opts.geometry),
 					ECORE_GETOPT_VALUE_BOOL(version),
 					ECORE_GETOPT_VALUE_BOOL(quit),
@@ -126,6 +151,8 @@ EAPI_MAIN int elm_main(int argc, char **argv)
 
 	int return_code = EXIT_FAILURE;
 
+	bench_mark(BENCH_STAGE_MAIN);
+
 	/* First step: initialize the logging framework */
 	_eovim_log_domain = eina_log_domain_register("eovim", EINA_COLOR_RED);
 	if (EINA_UNLIKELY(_eovim_log_domain < 0)) {
@@ -169,10 +196,20 @@ EAPI_MAIN int elm_main(int argc, char **argv)
 		goto log_unregister;
 	}
 
+	/* When the daemon took over, we are done. Otherwise, just start as usual */
+	if (opts.client && !opts.daemon) {
+		if (daemon_client_open((const char *const *)argv + args)) {
+			return_code = EXIT_SUCCESS;
+			goto log_unregister;
+		}
+		WRN("The eovim daemon could not open the files. Starting eovim");
+	}
+
 	/*
-    * App settings
+    * App settings. The daemon keeps running when its windows are closed.
     */
-	elm_policy_set(ELM_POLICY_QUIT, ELM_POLICY_QUIT_LAST_WINDOW_CLOSED);
+	elm_policy_set(ELM_POLICY_QUIT, (opts.daemon) ? ELM_POLICY_QUIT_NONE
+						      : ELM_POLICY_QUIT_LAST_WINDOW_CLOSED);
 	elm_language_set("");
 	elm_app_compile_bin_dir_set(PACKAGE_BIN_DIR);
 	elm_app_compile_lib_dir_set(PACKAGE_LIB_DIR);
@@ -198,14 +235,27 @@ EAPI_MAIN int elm_main(int argc, char **argv)
 			goto modules_shutdown;
 		}
 	}
+	bench_mark(BENCH_STAGE_MODULES);
 
 	/*=========================================================================
-    * Create the Neovim handler
+    * Create the Neovim handler. The daemon creates its own, and runs until it
+    * is killed. Other instances may be created while running.
     *========================================================================*/
-	struct nvim *const nvim = nvim_new(&opts, (const char *const *)argv + args);
-	if (EINA_UNLIKELY(!nvim)) {
-		CRI("Failed to create a NeoVim instance");
-		goto modules_shutdown;
+	if (opts.daemon) {
+		if (EINA_UNLIKELY(!daemon_start(&opts, (const char *const *)argv + args))) {
+			CRI("Failed to start the eovim daemon");
+			goto modules_shutdown;
+		}
+	} else {
+		struct nvim *const nvim = nvim_new(&opts, (const char *const *)argv + args);
+		if (EINA_UNLIKELY(!nvim)) {
+			CRI("Failed to create a NeoVim instance");
+			goto modules_shutdown;
+		}
+		bench_mark(BENCH_STAGE_GUI);
+
+		/* Show the last screen of this directory while neovim starts */
+		snapshot_load(nvim);
 	}
 
 	/*=========================================================================
@@ -213,7 +263,14 @@ EAPI_MAIN int elm_main(int argc, char **argv)
     *========================================================================*/
 	elm_run();
 
-	nvim_free(nvim);
+	if (opts.daemon)
+		daemon_stop();
+	nvim_free_all();
+	if (opts.bench_startup)
+		bench_report();
+	/* Reported after nvim_free_all(): what remains in use was not released */
+	if (opts.mem_report)
+		mem_report();
 
 	/* Everything seemed to have run fine :) */
 	return_code = EXIT_SUCCESS;
@@ -7,123 +7,60 @@
 #include "eovim/nvim_event.h"
 #include "eovim/nvim_request.h"
 #include "eovim/nvim_helper.h"
+#include "eovim/snapshot.h"
+#include "eovim/paste.h"
+#include "eovim/clipboard.h"
+#include "eovim/journal.h"
 #include "eovim/msgpack_helper.h"
 #include "eovim/log.h"
+#include "eovim/mem.h"
 #include "eovim/main.h"
 
 /*============================================================================*
  *                                 Private API                                *
  *============================================================================*/
 
-static Eina_Bool _handle_request(struct nvim *nvim, const msgpack_object_array *args)
-{
-	/* Retrieve the request identifier ****************************************/
-	if (EINA_UNLIKELY(args->ptr[1].type != MSGPACK_OBJECT_POSITIVE_INTEGER)) {
-		ERR("Second argument in request is expected to be an integer");
-		return EINA_FALSE;
-	}
-	const uint64_t long_req_id = args->ptr[1].via.u64;
-	if (EINA_UNLIKELY(long_req_id > UINT32_MAX)) {
-		ERR("Request ID '%" PRIu64 " is too big", long_req_id);
-		return EINA_FALSE;
-	}
-	const uint32_t req_id = (uint32_t)long_req_id;
-
-	/* Retrieve the request arguments *****************************************/
-	if (EINA_UNLIKELY(args->ptr[3].type != MSGPACK_OBJECT_ARRAY)) {
-		ERR("Fourth argument in request is expected to be an array");
-		return EINA_FALSE;
-	}
-	const msgpack_object_array *const req_args = &(args->ptr[3].via.array);
+/* Neovim instances that are alive, and the ones waiting to be freed */
+static Eina_Inlist *_nvims = NULL;
+static Eina_List *_released = NULL;
+static Ecore_Job *_release_job = NULL;
 
-	/* Retrieve the request name **********************************************/
-	if (EINA_UNLIKELY(args->ptr[2].type != MSGPACK_OBJECT_STR)) {
-		ERR("Third argument in request is expected to be a string");
-		return EINA_FALSE;
-	}
-	const msgpack_object_str *const str = &(args->ptr[2].via.str);
-	Eina_Stringshare *const request = eina_stringshare_add_length(str->ptr, str->size);
-	if (EINA_UNLIKELY(!request)) {
-		ERR("Failed to create stringshare");
-		return EINA_FALSE;
-	}
+/* Time (in seconds) spent at most processing the messages of neovim within an
+ * iteration of the main loop. The next ones are processed by the next
+ * iteration, after the inputs it received */
+#define NVIM_DISPATCH_BUDGET 0.004
 
-	const Eina_Bool ok = nvim_request_process(nvim, request, req_args, req_id);
-	eina_stringshare_del(request);
-	return ok;
+static Eina_Bool _rpc_request_cb(void *const data, const uint32_t req_id,
+				 Eina_Stringshare *const method,
+				 const msgpack_object_array *const args)
+{
+	return nvim_request_process(data, method, args, req_id);
 }
 
-static Eina_Bool _handle_request_response(struct nvim *nvim, const msgpack_object_array *args)
+static Eina_Bool _rpc_response_cb(void *const data, const uint32_t req_id,
+				  const msgpack_object *const result)
 {
-	/* 2nd arg should be an integer */
-	if (EINA_UNLIKELY(args->ptr[1].type != MSGPACK_OBJECT_POSITIVE_INTEGER)) {
-		ERR("Second argument in response is expected to be an integer");
-		goto fail;
-	}
+	struct nvim *const nvim = data;
 
-	/* When this variable is se to EINA_TRUE, we won't process the response.
-    * This is here so we can go through the error message without crashing too
-    * early. */
-	Eina_Bool do_not_process = EINA_FALSE;
+	/* The request may have been sent with inputs */
+	journal_answered(nvim->journal, req_id);
 
 	/* Get the request from the pending requests list. */
-	const uint32_t req_id = (uint32_t)args->ptr[1].via.u64;
 	struct request *const req = nvim_api_request_find(nvim, req_id);
 	if (EINA_UNLIKELY(!req)) {
-		/* We probably should wait for the error message to be fetched back.
-         * So we start by throwing an error, then we tell that the response
-         * shall not be processed. */
 		CRI("Uh... received a response to request %" PRIu32 ", but it was not "
 		    "registered. Something wrong happend somewhere!",
 		    req_id);
-		do_not_process = EINA_TRUE;
-	} else
-		DBG("Received response to request %" PRIu32, req_id);
-
-	/* If 3rd arg is an array, this is an error message. */
-	const msgpack_object_type err_type = args->ptr[2].type;
-	if (err_type == MSGPACK_OBJECT_ARRAY) {
-		const msgpack_object_array *const err_args = &(args->ptr[2].via.array);
-		if (EINA_UNLIKELY(err_args->size != 2)) {
-			ERR("Error response is supposed to have two arguments");
-			goto fail_req;
-		}
-		if (EINA_UNLIKELY(err_args->ptr[1].type != MSGPACK_OBJECT_STR)) {
-			ERR("Error response is supposed to contain a string");
-			goto fail_req;
-		}
-		const msgpack_object_str *const e = &(err_args->ptr[1].via.str);
-		Eina_Stringshare *const err = eina_stringshare_add_length(e->ptr, e->size);
-		if (EINA_UNLIKELY(!err)) {
-			CRI("Failed to create stringshare");
-			goto fail_req;
-		}
-
-		CRI("Neovim reported an error: %s", err);
-		eina_stringshare_del(err);
-		goto fail_req;
-	} else if (err_type != MSGPACK_OBJECT_NIL) {
-		ERR("Error argument is of handled type 0x%x", err_type);
-		goto fail_req;
+		return EINA_FALSE;
 	}
 
-	/* At this point, we have had the chance to read the error message. If we
-    * did, we would have exited earlier. If not, exit right now. */
-	if (EINA_UNLIKELY(do_not_process == EINA_TRUE))
-		goto fail_req;
-
-	/* 4th argment, which contain the returned parameters */
-	const msgpack_object *const result = &(args->ptr[3]);
+	/* When neovim reported an error, the callback is still called, without
+	 * result, so it can release what the request held (e.g. a paste) */
 	nvim_api_request_call(nvim, req, result);
 
 	/* Now that we have found the request, we can remove it */
 	nvim_api_request_free(nvim, req);
-	return EINA_TRUE;
-
-fail_req:
-	nvim_api_request_free(nvim, req);
-fail:
-	return EINA_FALSE;
+	return result != NULL;
 }
 
 static Eina_Stringshare *_stringshare_extract(const msgpack_object *obj)
@@ -135,49 +72,29 @@ static Eina_Stringshare *_stringshare_extract(const msgpack_object *obj)
 		const msgpack_object_bin *const bin = &(obj->via.bin);
 		return eina_stringshare_add_length(bin->ptr, bin->size);
 	} else {
-		ERR("Second argument in notification is expected to be a string "
-		    "(or BIN string), but it is of type 0x%x",
+		ERR("Command name is expected to be a string (or BIN string), "
+		    "but it is of type 0x%x",
 		    obj->type);
 		return NULL;
 	}
 }
 
-static Eina_Bool _handle_notification(struct nvim *nvim, const msgpack_object_array *args)
+static Eina_Bool _rpc_notification_cb(void *const data, Eina_Stringshare *const method,
+				      const msgpack_object_array *const args_arr)
 {
-	/*
-    * 2nd argument must be a string (or bin string).
-    * It contains the METHOD to be called for the notification.
-    * We decore the string as a stringshare, to feed it to our table of
-    * methods.
-    */
-	Eina_Stringshare *const method = _stringshare_extract(&(args->ptr[1]));
-	if (EINA_UNLIKELY(!method)) {
-		CRI("Failed to create stringshare from Neovim method");
-		goto fail;
-	}
-	DBG("Received notification '%s'", method);
-
-	/*
-    * 3rd argument must be an array of objects
-    */
-	if (EINA_UNLIKELY(args->ptr[2].type != MSGPACK_OBJECT_ARRAY)) {
-		ERR("Third argument in notification is expected to be an array");
-		goto del_method;
-	}
-	const msgpack_object_array *const args_arr = &(args->ptr[2].via.array);
+	struct nvim *const nvim = data;
 
 	/* Find the method handler */
 	const struct method *const meth = nvim_event_method_find(method);
-	if (EINA_UNLIKELY(!meth)) {
-		goto del_method;
-	}
+	if (EINA_UNLIKELY(!meth))
+		return EINA_FALSE;
 
 	/*
-    * Go through the notification's commands. There are formatted of the form
-    * [ command_name, Args... ]
-    * So we expect arguments to be arrays of at least one element.
-    * command_name must be a string!
-    */
+	 * Go through the notification's commands. There are formatted of the form
+	 * [ command_name, Args... ]
+	 * So we expect arguments to be arrays of at least one element.
+	 * command_name must be a string!
+	 */
 	for (unsigned int i = 0; i < args_arr->size; i++) {
 		const msgpack_object *const arg = &(args_arr->ptr[i]);
 		if (EINA_UNLIKELY(arg->type != MSGPACK_OBJECT_ARRAY)) {
@@ -207,14 +124,78 @@ static Eina_Bool _handle_notification(struct nvim *nvim, const msgpack_object_ar
 
 	/* Notify we are done processing the batch of functions for this method */
 	nvim_event_method_batch_end(nvim, meth);
-
-	eina_stringshare_del(method);
 	return EINA_TRUE;
+}
 
-del_method:
-	eina_stringshare_del(method);
-fail:
-	return EINA_FALSE;
+static Eina_Bool _rpc_send_cb(void *const data, const void *const bytes, const size_t size)
+{
+	struct nvim *const nvim = data;
+	if (EINA_UNLIKELY(!nvim->exe))
+		return EINA_FALSE;
+	return ecore_exe_send(nvim->exe, bytes, (int)size);
+}
+
+static const struct rpc_handlers _rpc_handlers = {
+	.request = &_rpc_request_cb,
+	.response = &_rpc_response_cb,
+	.notification = &_rpc_notification_cb,
+	.send = &_rpc_send_cb,
+};
+
+/*============================================================================*
+ *                            Instances Lifecycle                             *
+ *============================================================================*/
+
+static void _nvim_event_handlers_del(struct nvim *nvim);
+
+static void _nvim_free(struct nvim *const nvim)
+{
+	paste_cancel(nvim);
+	clipboard_release(nvim);
+	if (nvim->dispatch_idler)
+		ecore_idler_del(nvim->dispatch_idler);
+	_nvim_event_handlers_del(nvim);
+	rpc_cleanup(&nvim->rpc);
+	grid_free(nvim->grid);
+	journal_free(nvim->journal);
+	eina_hash_free(nvim->cmdline_styles);
+	eina_hash_free(nvim->kind_styles);
+	mem_usage_update(MEM_POOL_KIND_STYLES, &nvim->kind_styles_mem, 0u);
+	eina_hash_free(nvim->modes);
+	free(nvim);
+}
+
+static void _release_job_cb(void *const data EINA_UNUSED)
+{
+	struct nvim *nvim;
+	_release_job = NULL;
+	EINA_LIST_FREE(_released, nvim)
+	_nvim_free(nvim);
+}
+
+static void _nvim_release(struct nvim *const nvim)
+{
+	/* We may be running from the event handlers of the instance. It is freed
+	 * once they are done */
+	_nvims = eina_inlist_remove(_nvims, EINA_INLIST_GET(nvim));
+	_released = eina_list_append(_released, nvim);
+	if (!_release_job)
+		_release_job = ecore_job_add(&_release_job_cb, NULL);
+}
+
+static void _nvim_win_del_cb(void *const data, Evas *const e EINA_UNUSED,
+			     Evas_Object *const obj EINA_UNUSED, void *const info EINA_UNUSED)
+{
+	struct nvim *const nvim = data;
+
+	/* The GUI is gone, and must not be used anymore. If neovim still runs
+	 * (see gui_die()), the instance is released once it exited */
+	clipboard_release(nvim);
+	nvim->gui.win = NULL;
+	if (nvim->exe)
+		ecore_exe_terminate(nvim->exe);
+	else
+		_nvim_release(nvim);
 }
 
 /*============================================================================*
@@ -229,14 +210,14 @@ static Eina_Bool _nvim_added_cb(void *const data, const int type EINA_UNUSED, vo
     * to be always set. This test prevents this spurious event to crash eovim */
 	if (EINA_LIKELY(event != NULL)) {
 		const Ecore_Exe_Event_Add *const info = event;
+		struct nvim *const nvim = data;
 
 		/* Hey, did you know that Edje actually launches a process... hello
       * efreed! This has been going on for years... Now make sure we only
-      * talk to neovim, and nobody else */
-		const char *const tag = ecore_exe_tag_get(info->exe);
-		if (tag && (0 == strcmp(tag, "neovim"))) {
+      * talk to our neovim, and nobody else (not even other neovims) */
+		if (info->exe == nvim->exe) {
 			INF("Nvim process with PID %i was created", ecore_exe_pid_get(info->exe));
-			nvim_attach(data);
+			nvim_attach(nvim);
 		}
 	}
 
@@ -247,108 +228,109 @@ static Eina_Bool _nvim_deleted_cb(void *data, int type EINA_UNUSED, void *event)
 {
 	const Ecore_Exe_Event_Del *const info = event;
 	struct nvim *const nvim = data;
+	if (info->exe != nvim->exe)
+		return ECORE_CALLBACK_PASS_ON;
 	const int pid = ecore_exe_pid_get(info->exe);
 
+	/* What neovim sent before exiting is processed at once */
+	if (nvim->dispatch_idler) {
+		ecore_idler_del(nvim->dispatch_idler);
+		nvim->dispatch_idler = NULL;
+		rpc_data_dispatch(&nvim->rpc, -1.0, NULL);
+	}
+
+	/* Ecore releases the process handle once the event is processed */
+	nvim->exe = NULL;
+
 	/* We consider that neovim crashed if it receives an uncaught signal */
-	if (info->signalled) {
+	if (info->signalled)
 		ERR("Process with PID %i died of uncaught signal %i", pid, info->exit_signal);
+	else
+		INF("Process with PID %i terminated with exit code %i", pid, info->exit_code);
+
+	/* Deleting the window releases the instance. A crash is reported to the
+	 * user, unless the window was never shown (e.g. a warm instance) */
+	if (!nvim->gui.win)
+		_nvim_release(nvim);
+	else if (info->signalled && evas_object_visible_get(nvim->gui.win))
 		gui_die(&nvim->gui,
 			"The Neovim process %i died. Eovim cannot continue its execution", pid);
-	} else {
-		INF("Process with PID %i terminated with exit code %i", pid, info->exit_code);
+	else {
+		/* What neovim displayed last is shown by the next startup */
+		if (!info->signalled)
+			snapshot_save(nvim);
 		gui_del(&nvim->gui);
 	}
 	return ECORE_CALLBACK_PASS_ON;
 }
 
-static Eina_Bool _nvim_received_data_cb(void *data, int type EINA_UNUSED, void *event)
+static Eina_Bool _dispatch_idler_cb(void *const data)
 {
-	/* See https://github.com/msgpack-rpc/msgpack-rpc/blob/master/spec.md */
-	const Ecore_Exe_Event_Data *const info = event;
 	struct nvim *const nvim = data;
-	msgpack_unpacker *const unpacker = &nvim->unpacker;
-	const size_t recv_size = (size_t)info->size;
-
-	DBG("Incoming data from PID %u (size %zu)", ecore_exe_pid_get(info->exe), recv_size);
-
-	/*
-    * We have received something from NeoVim. We now must deserialize this.
-    */
-	msgpack_unpacked result;
-
-	/* Resize the unpacking buffer if need be */
-	if (msgpack_unpacker_buffer_capacity(unpacker) < recv_size) {
-		const bool ret = msgpack_unpacker_reserve_buffer(unpacker, recv_size);
-		if (!ret) {
-			ERR("Memory reallocation of %zu bytes failed", recv_size);
-			goto end;
-		}
+	Eina_Bool pending = EINA_FALSE;
+
+	/* The window was rendered, and the inputs queued by the windowing system
+	 * were processed since the previous slice. They are sent first */
+	if (EINA_LIKELY(nvim->gui.win != NULL)) {
+		if (nvim->gui.termview)
+			termview_input_flush(nvim->gui.termview);
+		rpc_data_dispatch(&nvim->rpc, NVIM_DISPATCH_BUDGET, &pending);
 	}
-	/* This seems to be required, but that's plain inefficiency */
-	memcpy(msgpack_unpacker_buffer(unpacker), info->data, recv_size);
-	msgpack_unpacker_buffer_consumed(unpacker, recv_size);
-
-	msgpack_unpacked_init(&result);
-	for (;;) {
-		const msgpack_unpack_return ret = msgpack_unpacker_next(unpacker, &result);
-		if (ret == MSGPACK_UNPACK_CONTINUE) {
-			break;
-		} else if (EINA_UNLIKELY(ret != MSGPACK_UNPACK_SUCCESS)) {
-			ERR("Error while unpacking data from neovim (0x%x)", ret);
-			goto end_unpack;
-		}
-		const msgpack_object *const obj = &(result.data);
+	if (pending)
+		return ECORE_CALLBACK_RENEW;
 
-#if 0 /* Uncomment to roughly dump the received messages */
-        msgpack_object_print(stderr, *obj);
-        fprintf(stderr, "\n--------\n");
-#endif
+	nvim->dispatch_idler = NULL;
+	return ECORE_CALLBACK_CANCEL;
+}
 
-		if (EINA_UNLIKELY(obj->type != MSGPACK_OBJECT_ARRAY)) {
-			ERR("Unexpected msgpack type 0x%x", obj->type);
-			goto end_unpack;
+static void _nvim_dispatch(struct nvim *const nvim)
+{
+	/* Neovim may send redraws faster than we can process them (e.g. a
+	 * runaway :terminal). The next slice is processed once the main loop is
+	 * idle, so frames are rendered and inputs are processed between the
+	 * slices, instead of being queued behind the whole flood */
+	Eina_Bool pending = EINA_FALSE;
+	rpc_data_dispatch(&nvim->rpc, NVIM_DISPATCH_BUDGET, &pending);
+	if (pending && (!nvim->dispatch_idler)) {
+		nvim->dispatch_idler = ecore_idler_add(&_dispatch_idler_cb, nvim);
+		if (EINA_UNLIKELY(!nvim->dispatch_idler)) {
+			ERR("Failed to create idler. Processing all the messages right away");
+			rpc_data_dispatch(&nvim->rpc, -1.0, NULL);
 		}
+	}
+}
 
-		const msgpack_object_array *const args = &(obj->via.array);
-		const unsigned int response_args_count = 4u;
-		const unsigned int notif_args_count = 3u;
-		if ((args->size != response_args_count) && (args->size != notif_args_count)) {
-			ERR("Unexpected count of arguments: %u.", args->size);
-			goto end_unpack;
-		}
+static Eina_Bool _nvim_received_data_cb(void *data, int type EINA_UNUSED, void *event)
+{
+	const Ecore_Exe_Event_Data *const info = event;
+	struct nvim *const nvim = data;
+	if (info->exe != nvim->exe)
+		return ECORE_CALLBACK_PASS_ON;
+	const size_t recv_size = (size_t)info->size;
 
-		if (EINA_UNLIKELY(args->ptr[0].type != MSGPACK_OBJECT_POSITIVE_INTEGER)) {
-			ERR("First argument in response is expected to be an integer");
-			goto end_unpack;
-		}
-		switch (args->ptr[0].via.u64) {
-		case 0: /* msgpack-rpc request */
-			_handle_request(nvim, args);
-			break;
-
-		case 1: /* msgpack-rpc response */
-			_handle_request_response(nvim, args);
-			break;
-
-		case 2: /* msgpack-rpc notification */
-			_handle_notification(nvim, args);
-			break;
-
-		default:
-			ERR("Invalid message identifier %" PRIu64, args->ptr[0].via.u64);
-			goto end_unpack;
-		}
-	} /* End of message unpacking */
+	/* The window is gone: neovim is being terminated */
+	if (EINA_UNLIKELY(!nvim->gui.win))
+		return ECORE_CALLBACK_PASS_ON;
 
-end_unpack:
-	msgpack_unpacked_destroy(&result);
-end:
+	DBG("Incoming data from PID %u (size %zu)", ecore_exe_pid_get(info->exe), recv_size);
+	if (EINA_UNLIKELY(!rpc_data_feed(&nvim->rpc, info->data, recv_size)))
+		return ECORE_CALLBACK_PASS_ON;
+
+	/* The inputs received so far reach neovim before we process what it
+	 * sent. Idlers do not run while neovim keeps its output busy, so every
+	 * read also processes a slice of the messages that were left */
+	if (nvim->gui.termview)
+		termview_input_flush(nvim->gui.termview);
+	_nvim_dispatch(nvim);
 	return ECORE_CALLBACK_PASS_ON;
 }
 
-static Eina_Bool _nvim_received_error_cb(void *data EINA_UNUSED, int type EINA_UNUSED, void *event)
+static Eina_Bool _nvim_received_error_cb(void *data, int type EINA_UNUSED, void *event)
 {
 	const Ecore_Exe_Event_Data *const info = event;
+	const struct nvim *const nvim = data;
+	if (info->exe != nvim->exe)
+		return ECORE_CALLBACK_PASS_ON;
 	const char *const msg = info->data;
 	ERR("Error: %s", msg);
 	return ECORE_CALLBACK_PASS_ON;
@@ -409,12 +391,6 @@ static void _nvim_event_handlers_del(struct nvim *nvim)
  *                                 Public API                                 *
  *============================================================================*/
 
-uint32_t nvim_next_uid_get(struct nvim *nvim)
-{
-	/* Overflow is not an error */
-	return nvim->request_id++;
-}
-
 struct nvim *nvim_new(const struct options *opts, const char *const args[])
 {
 	EINA_SAFETY_ON_NULL_RETURN_VAL(opts, NULL);
@@ -432,6 +408,14 @@ struct nvim *nvim_new(const struct options *opts, const char *const args[])
 		goto fail;
 	}
 	ok = eina_strbuf_append_printf(cmdline, "\"%s\" --embed", opts->nvim);
+
+	/* Our vim runtime is sourced by neovim before init.vim, without waiting
+	 * for us to send it. See nvim_attach() */
+	const char *const dir = (main_in_tree_is()) ? SOURCE_DATA_DIR : elm_app_data_dir_get();
+	ok &= eina_strbuf_append_printf(cmdline,
+					" --cmd \"let g:eovim_channel = %u"
+					" | source %s/vim/runtime.vim | let &rtp.=',%s/vim'\"",
+					NVIM_STDIO_CHANNEL, dir, dir);
 	for (const char *arg = *args; arg != NULL; arg = *(++args))
 		ok &= eina_strbuf_append_printf(cmdline, " \"%s\"", arg);
 	if (EINA_UNLIKELY(!ok)) {
@@ -458,14 +442,27 @@ struct nvim *nvim_new(const struct options *opts, const char *const args[])
 	nvim->mouse_enabled = EINA_TRUE;
 
 	/* Initialze msgpack for RPC */
-	msgpack_sbuffer_init(&nvim->sbuffer);
-	msgpack_packer_init(&nvim->packer, &nvim->sbuffer, msgpack_sbuffer_write);
-	msgpack_unpacker_init(&nvim->unpacker, 2048);
+	if (EINA_UNLIKELY(!rpc_setup(&nvim->rpc, &_rpc_handlers, nvim))) {
+		CRI("Failed to setup the RPC client");
+		goto del_events;
+	}
+
+	nvim->grid = grid_new();
+	if (EINA_UNLIKELY(!nvim->grid)) {
+		CRI("Failed to create the grid");
+		goto del_rpc;
+	}
+
+	nvim->journal = journal_new();
+	if (EINA_UNLIKELY(!nvim->journal)) {
+		CRI("Failed to create the input journal");
+		goto del_grid;
+	}
 
 	nvim->modes = eina_hash_stringshared_new(EINA_FREE_CB(&nvim_mode_free));
 	if (EINA_UNLIKELY(!nvim->modes)) {
 		CRI("Failed to create hash map");
-		goto del_events;
+		goto del_journal;
 	}
 
 	nvim->kind_styles = eina_hash_stringshared_new(EINA_FREE_CB(&eina_stringshare_del));
@@ -480,12 +477,6 @@ struct nvim *nvim_new(const struct options *opts, const char *const args[])
 		goto del_kind_styles;
 	}
 
-	nvim->hl_groups = eina_hash_stringshared_new(NULL);
-	if (EINA_UNLIKELY(!nvim->hl_groups)) {
-		CRI("Failed to create hash map");
-		goto del_cmdline_styles;
-	}
-
 	/* Create the neovim process */
 	nvim->exe = ecore_exe_pipe_run(eina_strbuf_string_get(cmdline),
 				       ECORE_EXE_PIPE_READ | ECORE_EXE_PIPE_WRITE |
@@ -493,7 +484,7 @@ struct nvim *nvim_new(const struct options *opts, const char *const args[])
 				       nvim);
 	if (EINA_UNLIKELY(!nvim->exe)) {
 		CRI("Failed to execute nvim instance");
-		goto del_hl_group_styles;
+		goto del_cmdline_styles;
 	}
 	ecore_exe_tag_set(nvim->exe, "neovim");
 	DBG("Running %s", eina_strbuf_string_get(cmdline));
@@ -503,20 +494,26 @@ struct nvim *nvim_new(const struct options *opts, const char *const args[])
 		CRI("Failed to set up the graphical user interface");
 		goto del_process;
 	}
+	evas_object_event_callback_add(nvim->gui.win, EVAS_CALLBACK_DEL, &_nvim_win_del_cb, nvim);
+	_nvims = eina_inlist_append(_nvims, EINA_INLIST_GET(nvim));
 
 	eina_strbuf_free(cmdline);
 	return nvim;
 
 del_process:
 	ecore_exe_kill(nvim->exe);
-del_hl_group_styles:
-	eina_hash_free(nvim->hl_groups);
 del_cmdline_styles:
 	eina_hash_free(nvim->cmdline_styles);
 del_kind_styles:
 	eina_hash_free(nvim->kind_styles);
 del_modes:
 	eina_hash_free(nvim->modes);
+del_journal:
+	journal_free(nvim->journal);
+del_grid:
+	grid_free(nvim->grid);
+del_rpc:
+	rpc_cleanup(&nvim->rpc);
 del_events:
 	_nvim_event_handlers_del(nvim);
 del_mem:
@@ -527,34 +524,32 @@ fail:
 	return NULL;
 }
 
-void nvim_free(struct nvim *const nvim)
+void nvim_free_all(void)
 {
-	if (nvim) {
-		_nvim_event_handlers_del(nvim);
-		msgpack_sbuffer_destroy(&nvim->sbuffer);
-		msgpack_unpacker_destroy(&nvim->unpacker);
-		eina_hash_free(nvim->hl_groups);
-		eina_hash_free(nvim->cmdline_styles);
-		eina_hash_free(nvim->kind_styles);
-		eina_hash_free(nvim->modes);
-		free(nvim);
+	struct nvim *nvim;
+
+	if (_release_job) {
+		ecore_job_del(_release_job);
+		_release_job_cb(NULL);
+	}
+
+	while (_nvims) {
+		nvim = EINA_INLIST_CONTAINER_GET(_nvims, struct nvim);
+		_nvims = eina_inlist_remove(_nvims, _nvims);
+		if (nvim->exe)
+			ecore_exe_terminate(nvim->exe);
+		if (nvim->gui.win) {
+			evas_object_event_callback_del_full(nvim->gui.win, EVAS_CALLBACK_DEL,
+							    &_nvim_win_del_cb, nvim);
+			gui_del(&nvim->gui);
+		}
+		_nvim_free(nvim);
 	}
 }
 
 Eina_Bool nvim_flush(struct nvim *nvim)
 {
-	/* Send the data present in the msgpack buffer */
-	const Eina_Bool ok = ecore_exe_send(nvim->exe, nvim->sbuffer.data, (int)nvim->sbuffer.size);
-
-	/* Now that the data is gone (hopefully), clear the buffer */
-	if (EINA_UNLIKELY(!ok)) {
-		CRI("Failed to send %zu bytes to neovim", nvim->sbuffer.size);
-		msgpack_sbuffer_clear(&nvim->sbuffer);
-		return EINA_FALSE;
-	}
-	DBG("Sent %zu bytes to neovim", nvim->sbuffer.size);
-	msgpack_sbuffer_clear(&nvim->sbuffer);
-	return EINA_TRUE;
+	return rpc_flush(&nvim->rpc);
 }
 
 void nvim_mouse_enabled_set(struct nvim *nvim, Eina_Bool enable)
@@ -2,19 +2,38 @@
 
 #include "eovim/types.h"
 #include "eovim/log.h"
+#include "eovim/mem.h"
 #include "eovim/nvim_api.h"
 #include "eovim/nvim_event.h"
 #include "eovim/nvim.h"
+#include "eovim/msgpack_helper.h"
+#include "eovim/journal.h"
 
 struct request {
 	EINA_INLIST;
 	struct {
 		f_nvim_api_cb func;
 		void *data;
+		Eina_Free_Cb free; /**< Called on data when the request is freed */
 	} cb;
 	uint32_t uid;
 };
 
+struct batch_call {
+	f_nvim_api_cb func;
+	void *data;
+};
+
+struct nvim_api_batch {
+	/* The calls are packed in their own buffer, as the count of calls must
+	 * be known before they are written in the request */
+	msgpack_sbuffer sbuffer;
+	msgpack_packer packer;
+	Eina_Inarray *calls; /**< Callbacks of each call, by index */
+	f_nvim_api_batch_cb func;
+	void *data;
+};
+
 /* Mempool to allocate the requests */
 static Eina_Mempool *_mempool;
 
@@ -25,21 +44,22 @@ static struct request *_request_new(struct nvim *nvim, const char *rpc_name, siz
 		CRI("Failed to allocate memory for a request object");
 		return NULL;
 	}
+	mem_alloc_account(MEM_POOL_REQUESTS, sizeof(struct request));
 
-	req->uid = nvim_next_uid_get(nvim);
+	req->uid = rpc_next_uid_get(&nvim->rpc);
 	DBG("Preparing request '%s' with id %" PRIu32, rpc_name, req->uid);
 
 	/* The buffer MUST be empty before preparing another request. If this is not
     * the case, something went very wrong! Discard the buffer and keep going */
-	if (EINA_UNLIKELY(nvim->sbuffer.size != 0u)) {
+	if (EINA_UNLIKELY(nvim->rpc.sbuffer.size != 0u)) {
 		ERR("The buffer is not empty. I've messed up somewhere");
-		msgpack_sbuffer_clear(&nvim->sbuffer);
+		msgpack_sbuffer_clear(&nvim->rpc.sbuffer);
 	}
 
 	/* Keep the request around */
 	nvim->requests = eina_inlist_append(nvim->requests, EINA_INLIST_GET(req));
 
-	msgpack_packer *const pk = &nvim->packer;
+	msgpack_packer *const pk = &nvim->rpc.packer;
 	/*
     * Pack the message! It is an array of four (4) items:
     *  - the rpc type:
@@ -67,6 +87,51 @@ static Eina_Bool _request_send(struct nvim *nvim, struct request *req)
 	return EINA_TRUE;
 }
 
+/**
+ * Start a call to the API @p rpc_name. When a batch is being composed, the call
+ * is appended to it. Otherwise, it is a request of its own. The arguments of
+ * the call must then be packed with the returned packer, and the call sent
+ * with _call_send().
+ */
+static msgpack_packer *_call_new(struct nvim *const nvim, const char *const rpc_name,
+				 const size_t rpc_name_len, const f_nvim_api_cb func,
+				 void *const func_data, struct request **const req_ret)
+{
+	struct nvim_api_batch *const batch = nvim->batch;
+	if (batch) {
+		const struct batch_call call = { .func = func, .data = func_data };
+		if (EINA_UNLIKELY(eina_inarray_push(batch->calls, &call) < 0)) {
+			CRI("Failed to register call '%s' in batch", rpc_name);
+			return NULL;
+		}
+		DBG("Batching call '%s'", rpc_name);
+
+		/* Each call is a [method, args] pair */
+		msgpack_packer *const pk = &batch->packer;
+		msgpack_pack_array(pk, 2);
+		msgpack_pack_bin(pk, rpc_name_len);
+		msgpack_pack_bin_body(pk, rpc_name, rpc_name_len);
+		*req_ret = NULL;
+		return pk;
+	}
+
+	struct request *const req = _request_new(nvim, rpc_name, rpc_name_len);
+	if (EINA_UNLIKELY(!req)) {
+		CRI("Failed to create request");
+		return NULL;
+	}
+	req->cb.func = func;
+	req->cb.data = func_data;
+	*req_ret = req;
+	return &nvim->rpc.packer;
+}
+
+static Eina_Bool _call_send(struct nvim *const nvim, struct request *const req)
+{
+	/* Batched calls are sent by nvim_api_batch_end() */
+	return (req) ? _request_send(nvim, req) : EINA_TRUE;
+}
+
 struct request *nvim_api_request_find(const struct nvim *nvim, uint32_t req_id)
 {
 	struct request *req;
@@ -79,8 +144,11 @@ struct request *nvim_api_request_find(const struct nvim *nvim, uint32_t req_id)
 
 void nvim_api_request_free(struct nvim *nvim, struct request *req)
 {
+	if (req->cb.free)
+		req->cb.free(req->cb.data);
 	nvim->requests = eina_inlist_remove(nvim->requests, EINA_INLIST_GET(req));
 	eina_mempool_free(_mempool, req);
+	mem_free_account(MEM_POOL_REQUESTS, sizeof(struct request));
 }
 
 void nvim_api_request_call(struct nvim *nvim, const struct request *req,
@@ -103,7 +171,7 @@ Eina_Bool nvim_api_ui_attach(struct nvim *nvim, unsigned int width, unsigned int
 	req->cb.func = func;
 	req->cb.data = func_data;
 
-	msgpack_packer *const pk = &nvim->packer;
+	msgpack_packer *const pk = &nvim->rpc.packer;
 	msgpack_pack_array(pk, 3);
 	msgpack_pack_int64(pk, width);
 	msgpack_pack_int64(pk, height);
@@ -137,7 +205,7 @@ Eina_Bool nvim_api_get_api_info(struct nvim *nvim, f_nvim_api_cb cb, void *data)
 	req->cb.func = cb;
 	req->cb.data = data;
 
-	msgpack_packer *const pk = &nvim->packer;
+	msgpack_packer *const pk = &nvim->rpc.packer;
 	msgpack_pack_array(pk, 0);
 
 	return _request_send(nvim, req);
@@ -146,14 +214,12 @@ Eina_Bool nvim_api_get_api_info(struct nvim *nvim, f_nvim_api_cb cb, void *data)
 Eina_Bool nvim_api_ui_ext_set(struct nvim *const nvim, const char *const key, Eina_Bool enabled)
 {
 	const char api[] = "nvim_ui_set_option";
-
-	struct request *const req = _request_new(nvim, api, sizeof(api) - 1);
-	if (EINA_UNLIKELY(!req)) {
-		CRI("Failed to create request");
+	struct request *req;
+	msgpack_packer *const pk = _call_new(nvim, api, sizeof(api) - 1, NULL, NULL, &req);
+	if (EINA_UNLIKELY(!pk))
 		return EINA_FALSE;
-	}
+
 	const size_t len = strlen(key);
-	msgpack_packer *const pk = &nvim->packer;
 	msgpack_pack_array(pk, 2);
 	msgpack_pack_str(pk, len);
 	msgpack_pack_str_body(pk, key, len);
@@ -162,7 +228,7 @@ Eina_Bool nvim_api_ui_ext_set(struct nvim *const nvim, const char *const key, Ei
 	else
 		msgpack_pack_false(pk);
 	INF("Externalized UI option '%s' => %s", key, enabled ? "on" : "off");
-	return _request_send(nvim, req);
+	return _call_send(nvim, req);
 }
 
 Eina_Bool nvim_api_ui_try_resize(struct nvim *nvim, unsigned int width, unsigned height)
@@ -175,7 +241,7 @@ Eina_Bool nvim_api_ui_try_resize(struct nvim *nvim, unsigned int width, unsigned
 		return EINA_FALSE;
 	}
 
-	msgpack_packer *const pk = &nvim->packer;
+	msgpack_packer *const pk = &nvim->rpc.packer;
 	msgpack_pack_array(pk, 2);
 	msgpack_pack_int64(pk, width);
 	msgpack_pack_int64(pk, height);
@@ -187,85 +253,69 @@ Eina_Bool nvim_api_eval(struct nvim *nvim, const char *input, size_t input_size,
 			void *func_data)
 {
 	const char api[] = "nvim_eval";
-	struct request *const req = _request_new(nvim, api, sizeof(api) - 1);
-	if (EINA_UNLIKELY(!req)) {
-		CRI("Failed to create request");
+	struct request *req;
+	msgpack_packer *const pk = _call_new(nvim, api, sizeof(api) - 1, func, func_data, &req);
+	if (EINA_UNLIKELY(!pk))
 		return EINA_FALSE;
-	}
 	DBG("Evaluating VimL: %s", input);
-	req->cb.func = func;
-	req->cb.data = func_data;
 
-	msgpack_packer *const pk = &nvim->packer;
 	msgpack_pack_array(pk, 1);
 	msgpack_pack_str(pk, input_size);
 	msgpack_pack_str_body(pk, input, input_size);
 
-	return _request_send(nvim, req);
+	return _call_send(nvim, req);
 }
 
 Eina_Bool nvim_api_command_output(struct nvim *nvim, const char *input, size_t input_size,
 				  f_nvim_api_cb func, void *func_data)
 {
 	const char api[] = "nvim_command_output";
-	struct request *const req = _request_new(nvim, api, sizeof(api) - 1);
-	if (EINA_UNLIKELY(!req)) {
-		CRI("Failed to create request");
+	struct request *req;
+	msgpack_packer *const pk = _call_new(nvim, api, sizeof(api) - 1, func, func_data, &req);
+	if (EINA_UNLIKELY(!pk))
 		return EINA_FALSE;
-	}
 	DBG("Running nvim command: %s", input);
-	req->cb.func = func;
-	req->cb.data = func_data;
 
-	msgpack_packer *const pk = &nvim->packer;
 	msgpack_pack_array(pk, 1);
 	msgpack_pack_str(pk, input_size);
 	msgpack_pack_str_body(pk, input, input_size);
 
-	return _request_send(nvim, req);
+	return _call_send(nvim, req);
 }
 
 Eina_Bool nvim_api_get_var(struct nvim *nvim, const char *var, f_nvim_api_cb func, void *func_data)
 {
 	const char api[] = "nvim_get_var";
-	struct request *const req = _request_new(nvim, api, sizeof(api) - 1);
-	if (EINA_UNLIKELY(!req)) {
-		CRI("Failed to create request");
+	struct request *req;
+	msgpack_packer *const pk = _call_new(nvim, api, sizeof(api) - 1, func, func_data, &req);
+	if (EINA_UNLIKELY(!pk))
 		return EINA_FALSE;
-	}
-	req->cb.func = func;
-	req->cb.data = func_data;
 
 	const size_t var_size = strlen(var);
 
-	msgpack_packer *const pk = &nvim->packer;
 	msgpack_pack_array(pk, 1);
 	msgpack_pack_str(pk, var_size);
 	msgpack_pack_str_body(pk, var, var_size);
 
-	return _request_send(nvim, req);
+	return _call_send(nvim, req);
 }
 
 Eina_Bool nvim_api_command(struct nvim *nvim, const char *input, size_t input_size,
 			   f_nvim_api_cb func, void *func_data)
 {
 	const char api[] = "nvim_command";
-	struct request *const req = _request_new(nvim, api, sizeof(api) - 1);
-	if (EINA_UNLIKELY(!req)) {
-		CRI("Failed to create request");
+	struct request *req;
+	msgpack_packer *const pk = _call_new(nvim, api, sizeof(api) - 1, func, func_data, &req);
+	if (EINA_UNLIKELY(!pk))
 		return EINA_FALSE;
-	}
-	req->cb.func = func;
-	req->cb.data = func_data;
 
 	DBG("Running nvim command: %s", input);
 
-	msgpack_packer *const pk = &nvim->packer;
 	msgpack_pack_array(pk, 1);
 	msgpack_pack_str(pk, input_size);
 	msgpack_pack_str_body(pk, input, input_size);
 
-	return _request_send(nvim, req);
+	return _call_send(nvim, req);
 }
 
 Eina_Bool nvim_api_input(struct nvim *nvim, const char *input, size_t input_size)
@@ -277,11 +327,193 @@ Eina_Bool nvim_api_input(struct nvim *nvim, const char *input, size_t input_size
 		return EINA_FALSE;
 	}
 
-	msgpack_packer *const pk = &nvim->packer;
+	msgpack_packer *const pk = &nvim->rpc.packer;
 	msgpack_pack_array(pk, 1);
 	msgpack_pack_str(pk, input_size);
 	msgpack_pack_str_body(pk, input, input_size);
 
+	journal_sent(nvim->journal, JOURNAL_KIND_KEY, req->uid);
+	return _request_send(nvim, req);
+}
+
+static void _str_pack(msgpack_packer *const pk, const char *const str)
+{
+	const size_t len = strlen(str);
+	msgpack_pack_str(pk, len);
+	msgpack_pack_str_body(pk, str, len);
+}
+
+Eina_Bool nvim_api_input_mouse(struct nvim *const nvim, const char *const button,
+			       const char *const action, const char *const modifier,
+			       const unsigned int grid, const unsigned int row,
+			       const unsigned int col)
+{
+	const char api[] = "nvim_input_mouse";
+	struct request *const req = _request_new(nvim, api, sizeof(api) - 1);
+	if (EINA_UNLIKELY(!req)) {
+		CRI("Failed to create request");
+		return EINA_FALSE;
+	}
+
+	msgpack_packer *const pk = &nvim->rpc.packer;
+	msgpack_pack_array(pk, 6);
+	_str_pack(pk, button);
+	_str_pack(pk, action);
+	_str_pack(pk, modifier);
+	msgpack_pack_uint32(pk, grid);
+	msgpack_pack_uint32(pk, row);
+	msgpack_pack_uint32(pk, col);
+
+	const Eina_Bool wheel = !strcmp(button, "wheel");
+	journal_sent(nvim->journal, (wheel) ? JOURNAL_KIND_WHEEL : JOURNAL_KIND_MOUSE, req->uid);
+	return _request_send(nvim, req);
+}
+
+Eina_Bool nvim_api_paste(struct nvim *const nvim, const char *const data, const size_t size,
+			 const int phase, const f_nvim_api_cb func, void *const func_data)
+{
+	const char api[] = "nvim_paste";
+	struct request *req;
+	msgpack_packer *const pk = _call_new(nvim, api, sizeof(api) - 1, func, func_data, &req);
+	if (EINA_UNLIKELY(!pk))
+		return EINA_FALSE;
+
+	msgpack_pack_array(pk, 3);
+	msgpack_pack_str(pk, size);
+	msgpack_pack_str_body(pk, data, size);
+	msgpack_pack_true(pk); /* Convert CRLF line endings */
+	msgpack_pack_int(pk, phase);
+
+	return _call_send(nvim, req);
+}
+
+static void _batch_free(struct nvim_api_batch *const batch)
+{
+	eina_inarray_free(batch->calls);
+	msgpack_sbuffer_destroy(&batch->sbuffer);
+	free(batch);
+}
+
+static void _batch_calls_fail(struct nvim *const nvim, const struct nvim_api_batch *const batch,
+			      const unsigned int from)
+{
+	/* The calls that were not run get no result, as if they failed alone */
+	const unsigned int count = eina_inarray_count(batch->calls);
+	for (unsigned int i = from; i < count; i++) {
+		const struct batch_call *const call = eina_inarray_nth(batch->calls, i);
+		if (call->func)
+			call->func(nvim, call->data, NULL);
+	}
+}
+
+static void _batch_done_cb(struct nvim *const nvim, void *const data,
+			   const msgpack_object *const result)
+{
+	const struct nvim_api_batch *const batch = data;
+
+	/* nvim_call_atomic() itself failed: none of the calls were run */
+	if (EINA_UNLIKELY(!result)) {
+		_batch_calls_fail(nvim, batch, 0u);
+		return;
+	}
+
+	/* nvim_call_atomic() returns [results, error]. The error is NIL if all
+	 * calls succeeded, or [index, type, message] for the call that failed.
+	 * Calls after the failed one were not run. */
+	const msgpack_object_array *const ret = MPACK_ARRAY_EXTRACT(result, goto fail);
+	if (EINA_UNLIKELY(ret->size != 2u)) {
+		ERR("Batch response is expected to have two elements. Got %" PRIu32, ret->size);
+		goto fail;
+	}
+	const msgpack_object_array *const results = MPACK_ARRAY_EXTRACT(&ret->ptr[0], goto fail);
+
+	unsigned int error_index = NVIM_API_BATCH_NO_ERROR;
+	if (ret->ptr[1].type == MSGPACK_OBJECT_ARRAY) {
+		const msgpack_object_array *const err = &ret->ptr[1].via.array;
+		if ((err->size == 3u) && (err->ptr[0].type == MSGPACK_OBJECT_POSITIVE_INTEGER) &&
+		    (err->ptr[2].type == MSGPACK_OBJECT_STR)) {
+			const msgpack_object_str *const msg = &err->ptr[2].via.str;
+			error_index = (unsigned int)err->ptr[0].via.u64;
+			ERR("Call %u of batch failed: %.*s", error_index, (int)msg->size,
+			    msg->ptr);
+		} else
+			ERR("Malformed batch error");
+	}
+
+	/* Each call gets its own result, as if it was sent alone */
+	const unsigned int count = eina_inarray_count(batch->calls);
+	for (unsigned int i = 0u; (i < results->size) && (i < count); i++) {
+		const struct batch_call *const call = eina_inarray_nth(batch->calls, i);
+		if (call->func)
+			call->func(nvim, call->data, &results->ptr[i]);
+	}
+	_batch_calls_fail(nvim, batch, results->size);
+	if (batch->func)
+		batch->func(nvim, batch->data, results, error_index);
+	return;
+
+fail:
+	ERR("Failed to decode the response of a batch of %u calls",
+	    eina_inarray_count(batch->calls));
+	_batch_calls_fail(nvim, batch, 0u);
+}
+
+Eina_Bool nvim_api_batch_begin(struct nvim *const nvim)
+{
+	EINA_SAFETY_ON_FALSE_RETURN_VAL(nvim->batch == NULL, EINA_FALSE);
+
+	struct nvim_api_batch *const batch = calloc(1, sizeof(struct nvim_api_batch));
+	if (EINA_UNLIKELY(!batch)) {
+		CRI("Failed to allocate memory");
+		return EINA_FALSE;
+	}
+	batch->calls = eina_inarray_new(sizeof(struct batch_call), 4);
+	if (EINA_UNLIKELY(!batch->calls)) {
+		CRI("Failed to create inline array");
+		free(batch);
+		return EINA_FALSE;
+	}
+	msgpack_sbuffer_init(&batch->sbuffer);
+	msgpack_packer_init(&batch->packer, &batch->sbuffer, msgpack_sbuffer_write);
+
+	nvim->batch = batch;
+	return EINA_TRUE;
+}
+
+Eina_Bool nvim_api_batch_end(struct nvim *const nvim, const f_nvim_api_batch_cb func,
+			     void *const func_data)
+{
+	struct nvim_api_batch *const batch = nvim->batch;
+	EINA_SAFETY_ON_NULL_RETURN_VAL(batch, EINA_FALSE);
+	nvim->batch = NULL;
+
+	/* Nothing was batched: there is nothing to send */
+	const unsigned int count = eina_inarray_count(batch->calls);
+	if (count == 0u) {
+		_batch_free(batch);
+		return EINA_TRUE;
+	}
+
+	const char api[] = "nvim_call_atomic";
+	struct request *const req = _request_new(nvim, api, sizeof(api) - 1);
+	if (EINA_UNLIKELY(!req)) {
+		CRI("Failed to create request");
+		_batch_free(batch);
+		return EINA_FALSE;
+	}
+	batch->func = func;
+	batch->data = func_data;
+	req->cb.func = &_batch_done_cb;
+	req->cb.data = batch;
+	req->cb.free = EINA_FREE_CB(&_batch_free);
+
+	/* The only argument is the array of calls, that were already packed */
+	msgpack_packer *const pk = &nvim->rpc.packer;
+	msgpack_pack_array(pk, 1);
+	msgpack_pack_array(pk, count);
+	msgpack_sbuffer_write(&nvim->rpc.sbuffer, batch->sbuffer.data, batch->sbuffer.size);
+	DBG("Sending a batch of %u calls", count);
+
 	return _request_send(nvim, req);
 }
 
@@ -10,6 +10,7 @@
 #include <eovim/msgpack_helper.h>
 #include <eovim/log.h>
 #include <eovim/main.h>
+#include <eovim/bench.h>
 
 static unsigned int _version_fragment_decode(const msgpack_object *version)
 {
@@ -107,11 +108,10 @@ fail:
 }
 
 /******************************************************************************
- *                                  - 5 -
- *
- * The UI is now attached. The init.vim has been sourced. We will start by
- * fetching configuration variables, that will impact the theme and external
- * UI features.
+ * The UI is now attached. The init.vim has been sourced, and the VimEnter
+ * autocmd registered by our runtime just fired. We will start by fetching
+ * configuration variables, that will impact the theme and external UI
+ * features.
  *
  * This is a bit tricky, though... Indeed neovim has just sent a BLOCKING
  * request. That is: nothing will be displayed to the user until we answer the
@@ -121,11 +121,11 @@ static Eina_Bool _ui_attached_cb(struct nvim *const nvim,
 				 const msgpack_object_array *const args EINA_UNUSED,
 				 msgpack_packer *const pk, const uint32_t req_id)
 {
-	/* The "vimenter" request will not happen again. Delete */
-	nvim_request_del("vimenter");
+	bench_mark(BENCH_STAGE_UI_ATTACHED);
 
 	/* Load the user configuration */
 	nvim_helper_config_reload(nvim);
+	bench_mark(BENCH_STAGE_CONFIG);
 
 	/* Now, generate the response: everything went fine */
 	msgpack_pack_array(pk, 4);
@@ -141,76 +141,19 @@ static Eina_Bool _ui_attached_cb(struct nvim *const nvim,
 }
 
 /******************************************************************************
- *                                  - 4 -
- *
- * This is called after the VimEnter autocmd has been registered.
- * We will now really attach to nvim. It is the vimenter request that will
- * trigger the _ui_attached_cb handler
+ * This is called when neovim has processed nvim_ui_attach. It will now source
+ * the init.vim, and send the vimenter request that triggers _ui_attached_cb()
  *****************************************************************************/
-static void _vimenter_registered_cb(struct nvim *const nvim, void *const data EINA_UNUSED,
-				    const msgpack_object *const result EINA_UNUSED)
+static void _ui_attach_ack_cb(struct nvim *const nvim EINA_UNUSED, void *const data EINA_UNUSED,
+			      const msgpack_object *const result EINA_UNUSED)
 {
-	const Eina_Rectangle *const geo = &nvim->opts->geometry;
-	nvim_api_ui_attach(nvim, (unsigned)geo->w, (unsigned)geo->h, NULL, NULL);
+	bench_mark(BENCH_STAGE_ATTACH_ACK);
 }
 
 /******************************************************************************
- *                                  - 3 -
- *
- * This is called after we send our custom vim runtime. We will now register
- * a vimenter autocmd.
- *****************************************************************************/
-static void _eovim_runtime_loaded_cb(struct nvim *const nvim, void *const data,
-				     const msgpack_object *const result EINA_UNUSED)
-{
-	/* We re-use the strbuf previously used to compose the command that allows the
-	 * registration of the VimEnter autocmd */
-	Eina_Strbuf *const buf = data;
-
-	eina_strbuf_reset(buf);
-	eina_strbuf_append_printf(
-		buf, "autocmd VimEnter * call rpcrequest(%" PRIu64 ", 'vimenter')", nvim->channel);
-
-	/* Create the vimenter request handler, so we can be notified after
-	 * nvim_ui_attached has been processed */
-	nvim_request_add("vimenter", _ui_attached_cb);
-
-	/* Request the registration of the vimenter autocmd */
-	nvim_api_command(nvim, eina_strbuf_string_get(buf),
-			 (unsigned int)eina_strbuf_length_get(buf), &_vimenter_registered_cb, NULL);
-
-	eina_strbuf_free(buf);
-}
-
-/******************************************************************************
- *                                  - 2 -
- *
- * This is called after we have collected neovim's capabilities. We now send
- * our own vim runtime to neovim, before init.vim is sourced
- *****************************************************************************/
-static void _nvim_runtime_load(struct nvim *const nvim)
-{
-	Eina_Strbuf *const buf = eina_strbuf_new();
-	if (EINA_UNLIKELY(!buf)) {
-		CRI("Failed to allocate string buffer");
-		return;
-	}
-	eina_strbuf_append(buf, ":source ");
-
-	/* Compose the path to the runtime file */
-	const char *const dir = (main_in_tree_is()) ? SOURCE_DATA_DIR : elm_app_data_dir_get();
-	eina_strbuf_append_printf(buf, "%s/vim/runtime.vim", dir);
-	eina_strbuf_append_printf(buf, "| let &rtp.=',%s/vim'", dir);
-
-	/* Send it to neovim */
-	nvim_api_command(nvim, eina_strbuf_string_get(buf),
-			 (unsigned int)eina_strbuf_length_get(buf), &_eovim_runtime_loaded_cb, buf);
-}
-
-/******************************************************************************
- *                                  - 1 -
- *
- * This is called when neovim sends us its capabilities
+ * This is called when neovim sends us its capabilities. It happens while the
+ * UI attachment is already under way: we only abort if this neovim cannot
+ * work with eovim.
  *****************************************************************************/
 static void _api_decode_cb(struct nvim *nvim, void *data EINA_UNUSED, const msgpack_object *result)
 {
@@ -218,6 +161,8 @@ static void _api_decode_cb(struct nvim *nvim, void *data EINA_UNUSED, const msgp
 	 * 1) the channel ID.
 	 * 2) a dictionary containing meta information - that's what we want
 	 */
+	if (EINA_UNLIKELY(!result))
+		return;
 	if (EINA_UNLIKELY(result->type != MSGPACK_OBJECT_ARRAY)) {
 		ERR("An array is expected. Got type 0x%x", result->type);
 		return;
@@ -262,16 +207,23 @@ static void _api_decode_cb(struct nvim *nvim, void *data EINA_UNUSED, const msgp
 	/****************************************************************************
 	 * Now that we have decoded the API information, use them!
 	 *****************************************************************************/
+	bench_mark(BENCH_STAGE_API_INFO);
 	INF("Running Neovim version %u.%u.%u", nvim->version.major, nvim->version.minor,
 	    nvim->version.patch);
 
+	/* Our runtime sends the vimenter request on the channel NVIM_STDIO_CHANNEL,
+	 * as it is sourced before we could tell it our channel. */
+	if (EINA_UNLIKELY(nvim->channel != NVIM_STDIO_CHANNEL)) {
+		gui_die(&nvim->gui,
+			"Neovim %u.%u.%u attached eovim to channel %" PRIu64 " instead of %u. "
+			"Please upgrade neovim.",
+			nvim->version.major, nvim->version.minor, nvim->version.patch,
+			nvim->channel, NVIM_STDIO_CHANNEL);
+		return;
+	}
+
 	/* Okay, start running the GUI! */
 	gui_ready_set(&nvim->gui);
-
-	/****************************************************************************
-	 * Now that we are done with neovim's capabilities, time to load our initial
-	 * vimscript runtime, before the init.vim is sourced ***********************/
-	_nvim_runtime_load(nvim);
 }
 
 /******************************************************************************
@@ -279,14 +231,28 @@ static void _api_decode_cb(struct nvim *nvim, void *data EINA_UNUSED, const msgp
  * we are in an asynchronous world now (two processes talk to each other in a
  * non-blocking manner), callback chains are everywhere!
  *
- * We follow the ui-startup procedure (see :help ui-startup). Note that we
- * need to query the neovim API to determine what neovim can do (or cannot do).
- * We also want to query some variable set from vimscript, to use or not some
- * externalized UI features.
+ * We follow the ui-startup procedure (see :help ui-startup), but we don't wait
+ * for a response before going to the next step, as each round trip delays the
+ * first frame while neovim may still be busy starting:
+ *
+ * - our vim runtime is sourced from the command-line (--cmd), before init.vim.
+ *   It registers the VimEnter autocmd that sends us the vimenter request;
+ * - we query the neovim API to determine what neovim can do (or cannot do).
+ *   This is only checked when the response arrives;
+ * - we attach the UI right away. Neovim then sources init.vim and fires
+ *   VimEnter, which gets us to _ui_attached_cb().
  *
+ * The requests are all sent before going back to the main loop, so they are
+ * written to neovim at once.
  *****************************************************************************/
 void nvim_attach(struct nvim *const nvim)
 {
-	/* We first start be querying neovim's capabilities */
+	/* Be ready for the vimenter request before anything is sent. The handler
+	 * stays registered, as other neovim instances may attach later */
+	nvim_request_add("vimenter", _ui_attached_cb);
+
 	nvim_api_get_api_info(nvim, _api_decode_cb, NULL);
+
+	const Eina_Rectangle *const geo = &nvim->opts->geometry;
+	nvim_api_ui_attach(nvim, (unsigned)geo->w, (unsigned)geo->h, _ui_attach_ack_cb, NULL);
 }
@@ -292,6 +292,9 @@ static Eina_Bool _method_eovim_init(e_method method_id)
 
 	const s_method_ctor ctors[] = {
 		CB_CTOR("reload", nvim_event_eovim_reload),
+		CB_CTOR("config", nvim_event_eovim_config),
+		CB_CTOR("new_window", nvim_event_eovim_new_window),
+		CB_CTOR("clipboard_set", nvim_event_eovim_clipboard_set),
 	};
 
 	/* Register the name of the method as a stringshare */
@@ -5,6 +5,7 @@
 #include <eovim/msgpack_helper.h>
 #include <eovim/nvim_api.h>
 #include <eovim/log.h>
+#include <eovim/mem.h>
 #include <msgpack.h>
 
 Eina_Bool nvim_helper_autocmd_do(struct nvim *const nvim, const char *const event,
@@ -46,6 +47,16 @@ static void parse_theme_config_bool(struct nvim *const nvim EINA_UNUSED, void *c
 	*param = parse_config_boolean(result);
 }
 
+static void parse_config_bool(struct nvim *const nvim EINA_UNUSED, void *const data,
+			      const msgpack_object *const result)
+{
+	Eina_Bool *const param = data;
+	if (result->type == MSGPACK_OBJECT_BOOLEAN)
+		*param = result->via.boolean;
+	else
+		*param = parse_config_boolean(result);
+}
+
 static void parse_theme_config_double(struct nvim *const nvim EINA_UNUSED, void *const data,
 				      const msgpack_object *const result)
 {
@@ -84,6 +95,12 @@ static void parse_theme_config_animation_style(struct nvim *const nvim EINA_UNUS
 	}
 }
 
+static void parse_hud_config(struct nvim *const nvim, void *const data EINA_UNUSED,
+			     const msgpack_object *const result)
+{
+	gui_hud_enabled_set(&nvim->gui, parse_config_boolean(result));
+}
+
 static void parse_ext_config(struct nvim *const nvim, void *const data,
 			     const msgpack_object *const result)
 {
@@ -97,9 +114,12 @@ static void parse_styles_map(struct nvim *const nvim, void *const data,
 {
 	const msgpack_object_map *const map = MPACK_MAP_EXTRACT(result, return );
 	const msgpack_object *o_key, *o_val;
-	Eina_Hash *const hashmap = data;
+	Eina_Hash *const hashmap = *(Eina_Hash **)data;
+	size_t bytes = 0u;
 	unsigned int it;
 
+	/* The map replaces the previous one, so reloading does not pile up */
+	eina_hash_free_buckets(hashmap);
 	MPACK_MAP_ITER (map, it, o_key, o_val) {
 		Eina_Stringshare *const key = MPACK_STRING_EXTRACT(o_key, continue);
 		Eina_Stringshare *const val = MPACK_STRING_EXTRACT(o_val, continue);
@@ -110,40 +130,177 @@ static void parse_styles_map(struct nvim *const nvim, void *const data,
 			eina_stringshare_del(val);
 			continue;
 		}
+		bytes += (size_t)(eina_stringshare_strlen(key) + eina_stringshare_strlen(val)) + 2u;
 	}
+	if (hashmap == nvim->kind_styles)
+		mem_usage_update(MEM_POOL_KIND_STYLES, &nvim->kind_styles_mem, bytes);
+}
+
+struct config_var {
+	const char *name; /**< Name of the variable, without the g: prefix */
+	f_nvim_api_cb parse;
+	size_t offset; /**< Offset of the parsed value in struct nvim */
+	const char *ext; /**< When set, UI extension passed to parse instead */
+};
+
+#define CONFIG_VAR(Name, Parse, Field)                                                             \
+	{                                                                                          \
+		.name = Name, .parse = &(Parse), .offset = offsetof(struct nvim, Field),           \
+		.ext = NULL,                                                                       \
+	}
+#define CONFIG_EXT(Name, Ext)                                                                      \
+	{                                                                                          \
+		.name = Name, .parse = &parse_ext_config, .offset = 0u, .ext = Ext,                \
+	}
+
+static const struct config_var _config_vars[] = {
+	CONFIG_VAR("eovim_theme_bell_enabled", parse_theme_config_bool, gui.theme.bell_enabled),
+	CONFIG_VAR("eovim_theme_react_to_key_presses", parse_theme_config_bool,
+		   gui.theme.react_to_key_presses),
+	CONFIG_VAR("eovim_theme_react_to_caps_lock", parse_theme_config_bool,
+		   gui.theme.react_to_caps_lock),
+	CONFIG_VAR("eovim_cursor_cuts_ligatures", parse_theme_config_bool,
+		   gui.theme.cursor_cuts_ligatures),
+	CONFIG_VAR("eovim_cursor_animated", parse_theme_config_bool, gui.theme.cursor_animated),
+	CONFIG_VAR("eovim_cursor_animation_duration", parse_theme_config_double,
+		   gui.theme.cursor_animation_duration),
+	CONFIG_VAR("eovim_cursor_animation_style", parse_theme_config_animation_style,
+		   gui.theme.cursor_animation_style),
+	CONFIG_VAR("eovim_perf_hud", parse_hud_config, gui),
+	CONFIG_VAR("eovim_key_repeat_throttle", parse_config_bool, gui.key_repeat_throttle),
+	CONFIG_VAR("eovim_predictive_echo", parse_config_bool, gui.predictive_echo),
+	CONFIG_EXT("eovim_ext_tabline", "ext_tabline"),
+	CONFIG_EXT("eovim_ext_popupmenu", "ext_popupmenu"),
+	CONFIG_EXT("eovim_ext_cmdline", "ext_cmdline"),
+	CONFIG_VAR("eovim_theme_completion_styles", parse_styles_map, kind_styles),
+	CONFIG_VAR("eovim_theme_cmdline_styles", parse_styles_map, cmdline_styles),
+	//CONFIG_EXT("eovim_ext_multigrid", "ext_multigrid"),
+};
+
+#undef CONFIG_EXT
+#undef CONFIG_VAR
+
+static const struct config_var *_config_var_find(const msgpack_object_str *const name)
+{
+	for (size_t i = 0u; i < EINA_C_ARRAY_LENGTH(_config_vars); i++) {
+		const struct config_var *const var = &_config_vars[i];
+		if ((strlen(var->name) == name->size) && !strncmp(var->name, name->ptr, name->size))
+			return var;
+	}
+	return NULL;
+}
+
+static void _config_var_apply(struct nvim *const nvim, const struct config_var *const var,
+			      const msgpack_object *const value)
+{
+	void *const param = (var->ext) ? (void *)var->ext : (char *)nvim + var->offset;
+	var->parse(nvim, param, value);
+}
+
+static void _config_decode_cb(struct nvim *const nvim, void *const data EINA_UNUSED,
+			      const msgpack_object *const result)
+{
+	if (EINA_UNLIKELY(!result))
+		return;
+	const msgpack_object_map *const map = MPACK_MAP_EXTRACT(result, return );
+	const msgpack_object *o_key, *o_val;
+	unsigned int it;
+
+	/* The UI extensions are all set with a single request */
+	const Eina_Bool batched = nvim_api_batch_begin(nvim);
+
+	/* Variables we don't know about (e.g. set by the user) are ignored */
+	MPACK_MAP_ITER (map, it, o_key, o_val) {
+		const msgpack_object_str *const name = MPACK_STRING_OBJ_EXTRACT(o_key, continue);
+		const struct config_var *const var = _config_var_find(name);
+		if (var != NULL)
+			_config_var_apply(nvim, var, o_val);
+	}
+	if (batched)
+		nvim_api_batch_end(nvim, NULL, NULL);
+
+	/* All the styles are now known: update them all at once */
 	termview_style_update(nvim->gui.termview);
 }
 
-Eina_Bool nvim_helper_config_reload(struct nvim *const nvim)
+Eina_Bool nvim_helper_config_set(struct nvim *const nvim, const msgpack_object_str *const name,
+				 const msgpack_object *const value)
 {
-	struct gui *const gui = &nvim->gui;
-
-	/* Retrive theme-oriented configuration */
-	nvim_api_get_var(nvim, "eovim_theme_bell_enabled", &parse_theme_config_bool,
-			 &gui->theme.bell_enabled);
-	nvim_api_get_var(nvim, "eovim_theme_react_to_key_presses", &parse_theme_config_bool,
-			 &gui->theme.react_to_key_presses);
-	nvim_api_get_var(nvim, "eovim_theme_react_to_caps_lock", &parse_theme_config_bool,
-			 &gui->theme.react_to_caps_lock);
-
-	nvim_api_get_var(nvim, "eovim_cursor_cuts_ligatures", &parse_theme_config_bool,
-			 &gui->theme.cursor_cuts_ligatures);
-	nvim_api_get_var(nvim, "eovim_cursor_animated", &parse_theme_config_bool,
-			 &gui->theme.cursor_animated);
-	nvim_api_get_var(nvim, "eovim_cursor_animation_duration", &parse_theme_config_double,
-			 &gui->theme.cursor_animation_duration);
-	nvim_api_get_var(nvim, "eovim_cursor_animation_style", &parse_theme_config_animation_style,
-			 &gui->theme.cursor_animation_style);
-
-	nvim_api_get_var(nvim, "eovim_ext_tabline", &parse_ext_config, "ext_tabline");
-	nvim_api_get_var(nvim, "eovim_ext_popupmenu", &parse_ext_config, "ext_popupmenu");
-	nvim_api_get_var(nvim, "eovim_ext_cmdline", &parse_ext_config, "ext_cmdline");
-
-	nvim_api_get_var(nvim, "eovim_theme_completion_styles", &parse_styles_map,
-			 nvim->kind_styles);
-	nvim_api_get_var(nvim, "eovim_theme_cmdline_styles", &parse_styles_map,
-			 nvim->cmdline_styles);
-	//nvim_api_get_var(nvim, "eovim_ext_multigrid",
-	//  &parse_config_boolean, &gui->ext.multigrid);
+	const struct config_var *const var = _config_var_find(name);
+	if (var == NULL) {
+		/* Not a setting (e.g. g:eovim_running) */
+		DBG("Ignoring variable 'g:%.*s'", (int)name->size, name->ptr);
+		return EINA_TRUE;
+	}
+	_config_var_apply(nvim, var, value);
+
+	/* Only the styles maps require the styles to be re-generated */
+	if (var->parse == &parse_styles_map)
+		termview_style_update(nvim->gui.termview);
 	return EINA_TRUE;
 }
+
+Eina_Bool nvim_helper_config_reload(struct nvim *const nvim)
+{
+	/* Retrieve all the configuration variables at once, in a dictionary */
+	const char expr[] = "filter(copy(g:), 'v:key =~# \"^eovim_\"')";
+	return nvim_api_eval(nvim, expr, sizeof(expr) - 1u, &_config_decode_cb, NULL);
+}
+
+static void _vim_string_append(Eina_Strbuf *const buf, const char *const str, const size_t len)
+{
+	/* Single-quoted vim strings only need their quotes to be doubled */
+	eina_strbuf_append_char(buf, '\'');
+	for (size_t i = 0u; i < len; i++) {
+		if (str[i] == '\'')
+			eina_strbuf_append_char(buf, '\'');
+		eina_strbuf_append_char(buf, str[i]);
+	}
+	eina_strbuf_append_char(buf, '\'');
+}
+
+Eina_Bool nvim_helper_files_open(struct nvim *const nvim, const msgpack_object_array *const args)
+{
+	if (EINA_UNLIKELY((args->size != 2u) || (args->ptr[0].type != MSGPACK_OBJECT_STR) ||
+			  (args->ptr[1].type != MSGPACK_OBJECT_ARRAY))) {
+		ERR("Expected arguments [cwd, [file...]]");
+		return EINA_FALSE;
+	}
+	const msgpack_object_str *const cwd = &(args->ptr[0].via.str);
+	const msgpack_object_array *const files = &(args->ptr[1].via.array);
+	for (uint32_t i = 0u; i < files->size; i++) {
+		if (EINA_UNLIKELY(files->ptr[i].type != MSGPACK_OBJECT_STR)) {
+			ERR("Files are expected to be strings. Got type 0x%x", files->ptr[i].type);
+			return EINA_FALSE;
+		}
+	}
+
+	Eina_Strbuf *const cmd = eina_strbuf_new();
+	if (EINA_UNLIKELY(!cmd)) {
+		CRI("Failed to create strbuf");
+		return EINA_FALSE;
+	}
+
+	/* The paths are escaped by neovim itself. The commands are sent together,
+	 * unless a batch is already being composed: they are then part of it */
+	const Eina_Bool batched = nvim_api_batch_begin(nvim);
+	eina_strbuf_append(cmd, "execute 'cd' fnameescape(");
+	_vim_string_append(cmd, cwd->ptr, cwd->size);
+	eina_strbuf_append_char(cmd, ')');
+	nvim_api_command(nvim, eina_strbuf_string_get(cmd), eina_strbuf_length_get(cmd), NULL,
+			 NULL);
+	if (files->size != 0u) {
+		eina_strbuf_reset(cmd);
+		eina_strbuf_append(cmd, "execute 'args'");
+		for (uint32_t i = 0u; i < files->size; i++) {
+			const msgpack_object_str *const file = &(files->ptr[i].via.str);
+			eina_strbuf_append(cmd, " fnameescape(");
+			_vim_string_append(cmd, file->ptr, file->size);
+			eina_strbuf_append_char(cmd, ')');
+		}
+		nvim_api_command(nvim, eina_strbuf_string_get(cmd), eina_strbuf_length_get(cmd),
+				 NULL, NULL);
+	}
+	eina_strbuf_free(cmd);
+	return (batched) ? nvim_api_batch_end(nvim, NULL, NULL) : EINA_TRUE;
+}
@@ -13,6 +13,12 @@ static Eina_Hash *_nvim_requests;
 Eina_Bool nvim_request_add(const char *request_name, f_nvim_request_cb func)
 {
 	Eina_Stringshare *const name = eina_stringshare_add(request_name);
+
+	/* Registering the same handler again is harmless */
+	if (eina_hash_find(_nvim_requests, name) == func) {
+		eina_stringshare_del(name);
+		return EINA_TRUE;
+	}
 	const Eina_Bool ok = eina_hash_direct_add(_nvim_requests, name, func);
 	if (EINA_UNLIKELY(!ok)) {
 		ERR("Failed to register request \"%s\"", request_name);
@@ -50,13 +56,13 @@ Eina_Bool nvim_request_process(struct nvim *nvim, Eina_Stringshare *request,
 {
 	/* This function shall only be used on the main loop. Otherwise, we cannot
     * use this packer */
-	msgpack_packer *const pk = &nvim->packer;
+	msgpack_packer *const pk = &nvim->rpc.packer;
 
 	/* The buffer MUST be empty before preparing the response. If this is not
     * the case, something went very wrong! Discard the buffer and keep going */
-	if (EINA_UNLIKELY(nvim->sbuffer.size != 0u)) {
+	if (EINA_UNLIKELY(nvim->rpc.sbuffer.size != 0u)) {
 		ERR("The buffer is not empty. I've messed up somewhere");
-		msgpack_sbuffer_clear(&nvim->sbuffer);
+		msgpack_sbuffer_clear(&nvim->rpc.sbuffer);
 	}
 
 	/*
@@ -0,0 +1,152 @@
+/* This file is part of Eovim, which is under the MIT License ****************/
+
+#include "eovim/paste.h"
+#include "eovim/nvim.h"
+#include "eovim/nvim_api.h"
+#include "eovim/log.h"
+
+/* Largest chunk of text given to a single call of nvim_paste */
+#define PASTE_CHUNK_SIZE (64u * 1024u)
+
+/* Phases of nvim_paste */
+#define PASTE_PHASE_SINGLE -1
+#define PASTE_PHASE_FIRST 1
+#define PASTE_PHASE_NEXT 2
+#define PASTE_PHASE_LAST 3
+
+struct paste {
+	char *text;
+	size_t size;
+	size_t sent; /**< Count of bytes of @p text already sent */
+	Ecore_Job *job; /**< Sends the next chunk */
+};
+
+static void _paste_free(struct nvim *const nvim)
+{
+	struct paste *const paste = nvim->paste;
+	if (paste->job)
+		ecore_job_del(paste->job);
+	free(paste->text);
+	free(paste);
+	nvim->paste = NULL;
+}
+
+static size_t _chunk_size_get(const struct paste *const paste)
+{
+	const size_t left = paste->size - paste->sent;
+	if (left <= PASTE_CHUNK_SIZE)
+		return left;
+
+	/* Prefer to cut after a newline, so each chunk is made of whole lines */
+	const char *const start = paste->text + paste->sent;
+	for (size_t i = PASTE_CHUNK_SIZE; i > PASTE_CHUNK_SIZE / 2u; i--) {
+		if (start[i - 1u] == '\n')
+			return i;
+	}
+
+	/* Otherwise, never cut a UTF-8 sequence: the chunk ends before the
+	 * continuation bytes (10xxxxxx) of the character it would split */
+	size_t size = PASTE_CHUNK_SIZE;
+	while ((size > PASTE_CHUNK_SIZE - 4u) && (((unsigned char)start[size] & 0xc0u) == 0x80u))
+		size--;
+	return size;
+}
+
+static void _paste_done_cb(struct nvim *nvim, void *data, const msgpack_object *result);
+
+static void _paste_send_cb(void *const data)
+{
+	struct nvim *const nvim = data;
+	struct paste *const paste = nvim->paste;
+	paste->job = NULL;
+
+	const size_t size = _chunk_size_get(paste);
+	const Eina_Bool first = (paste->sent == 0u);
+	const Eina_Bool last = (paste->sent + size == paste->size);
+	int phase;
+	if (first)
+		phase = (last) ? PASTE_PHASE_SINGLE : PASTE_PHASE_FIRST;
+	else
+		phase = (last) ? PASTE_PHASE_LAST : PASTE_PHASE_NEXT;
+
+	DBG("Pasting %zu bytes (phase %i)", size, phase);
+	const Eina_Bool ok = nvim_api_paste(nvim, paste->text + paste->sent, size, phase,
+					    &_paste_done_cb, NULL);
+	if (EINA_UNLIKELY(!ok)) {
+		ERR("Failed to send a chunk of the paste. Aborting");
+		_paste_free(nvim);
+		return;
+	}
+	paste->sent += size;
+}
+
+static void _paste_done_cb(struct nvim *const nvim, void *const data EINA_UNUSED,
+			   const msgpack_object *const result)
+{
+	struct paste *const paste = nvim->paste;
+
+	/* The paste was cancelled while neovim was processing the chunk */
+	if (!paste)
+		return;
+
+	/* Neovim returns false when the paste must stop (e.g. the user pressed
+	 * <Esc>), and there is no result when it failed (e.g. the buffer is not
+	 * modifiable). Either way, the next paste can start */
+	if ((!result) || (result->type != MSGPACK_OBJECT_BOOLEAN) || (!result->via.boolean)) {
+		INF("The paste was interrupted after %zu bytes", paste->sent);
+		_paste_free(nvim);
+		return;
+	}
+	if (paste->sent == paste->size) {
+		_paste_free(nvim);
+		return;
+	}
+
+	/* Neovim processed the previous chunk. The next one is sent at the end
+	 * of this iteration of the main loop */
+	paste->job = ecore_job_add(&_paste_send_cb, nvim);
+	if (EINA_UNLIKELY(!paste->job)) {
+		ERR("Failed to create job. Aborting the paste");
+		_paste_free(nvim);
+	}
+}
+
+Eina_Bool paste_start(struct nvim *const nvim, const char *const text, const size_t size)
+{
+	EINA_SAFETY_ON_NULL_RETURN_VAL(text, EINA_FALSE);
+	EINA_SAFETY_ON_TRUE_RETURN_VAL(size == 0u, EINA_FALSE);
+
+	if (nvim->paste) {
+		WRN("A paste is already in progress. Ignoring %zu bytes", size);
+		return EINA_FALSE;
+	}
+
+	struct paste *const paste = calloc(1, sizeof(struct paste));
+	if (EINA_UNLIKELY(!paste)) {
+		CRI("Failed to allocate memory");
+		return EINA_FALSE;
+	}
+	paste->text = malloc(size);
+	if (EINA_UNLIKELY(!paste->text)) {
+		CRI("Failed to allocate %zu bytes", size);
+		free(paste);
+		return EINA_FALSE;
+	}
+	memcpy(paste->text, text, size);
+	paste->size = size;
+	nvim->paste = paste;
+
+	paste->job = ecore_job_add(&_paste_send_cb, nvim);
+	if (EINA_UNLIKELY(!paste->job)) {
+		CRI("Failed to create job");
+		_paste_free(nvim);
+		return EINA_FALSE;
+	}
+	return EINA_TRUE;
+}
+
+void paste_cancel(struct nvim *const nvim)
+{
+	if (nvim->paste)
+		_paste_free(nvim);
+}
@@ -0,0 +1,228 @@
+/* This file is part of Eovim, which is under the MIT License ****************/
+
+#include "eovim/snapshot.h"
+#include "eovim/cache.h"
+#include "eovim/nvim.h"
+#include "eovim/grid.h"
+#include "eovim/gui.h"
+#include "eovim/log.h"
+
+#include <limits.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+/* Bump it whenever the layout of the snapshot changes */
+#define SNAPSHOT_VERSION 1u
+
+/* Snapshots of the directories eovim was not started from for this long
+ * (in seconds) are removed, as are the oldest ones past SNAPSHOT_MAX */
+#define SNAPSHOT_MAX_AGE (30 * 24 * 3600)
+#define SNAPSHOT_MAX 32u
+
+#define SNAPSHOT_DIR "eovim/snapshots"
+
+struct snapshot_file {
+	time_t mtime;
+	Eina_Stringshare *path;
+};
+
+static Eina_Bool _snapshot_enabled(const struct options *const opts)
+{
+	/* Warm instances are not started from the user's working directory,
+	 * and a benchmark must not depend on a previous session */
+	return !opts->daemon && !opts->bench_startup && !opts->no_snapshot;
+}
+
+static Eina_Bool _snapshot_path_get(char *const path, const size_t path_size, char *const cwd,
+				    const size_t cwd_size)
+{
+	if (EINA_UNLIKELY(!getcwd(cwd, cwd_size))) {
+		ERR("Failed to get the current working directory: %s", strerror(errno));
+		return EINA_FALSE;
+	}
+
+	/* The cwd is also stored in the snapshot, to detect hash collisions */
+	const unsigned int hash = (unsigned int)eina_hash_superfast(cwd, (int)strlen(cwd));
+	char name[32];
+	snprintf(name, sizeof(name), SNAPSHOT_DIR "/%08x", hash);
+	return cache_path_get(path, path_size, name);
+}
+
+static Eina_Bool _msgpack_uint_is(const msgpack_object *const obj, const uint64_t value)
+{
+	return (obj->type == MSGPACK_OBJECT_POSITIVE_INTEGER) && (obj->via.u64 == value);
+}
+
+static int _snapshot_file_cmp(const void *const a, const void *const b)
+{
+	/* The most recent snapshots come first */
+	const struct snapshot_file *const fa = a;
+	const struct snapshot_file *const fb = b;
+	return (fa->mtime < fb->mtime) - (fa->mtime > fb->mtime);
+}
+
+static void _snapshots_prune(void)
+{
+	char dir[PATH_MAX];
+	if (EINA_UNLIKELY(!cache_path_get(dir, sizeof(dir), SNAPSHOT_DIR)))
+		return;
+	Eina_Iterator *const it = eina_file_direct_ls(dir);
+	if (EINA_UNLIKELY(!it))
+		return;
+	Eina_Inarray *const files = eina_inarray_new(sizeof(struct snapshot_file), 16);
+	if (EINA_UNLIKELY(!files)) {
+		CRI("Failed to create inline array");
+		goto end;
+	}
+
+	const time_t now = time(NULL);
+	const Eina_File_Direct_Info *info;
+	EINA_ITERATOR_FOREACH (it, info) {
+		struct stat st;
+		if ((stat(info->path, &st) != 0) || (!S_ISREG(st.st_mode)))
+			continue;
+		if (now - st.st_mtime > SNAPSHOT_MAX_AGE) {
+			DBG("Removing the outdated snapshot '%s'", info->path);
+			unlink(info->path);
+			continue;
+		}
+		const struct snapshot_file file = {
+			.mtime = st.st_mtime,
+			.path = eina_stringshare_add(info->path),
+		};
+		if (EINA_UNLIKELY(eina_inarray_push(files, &file) < 0))
+			eina_stringshare_del(file.path);
+	}
+
+	if (eina_inarray_count(files) > SNAPSHOT_MAX)
+		eina_inarray_sort(files, &_snapshot_file_cmp);
+	for (unsigned int i = 0u; i < eina_inarray_count(files); i++) {
+		const struct snapshot_file *const file = eina_inarray_nth(files, i);
+		if (i >= SNAPSHOT_MAX) {
+			DBG("Removing the snapshot '%s'", file->path);
+			unlink(file->path);
+		}
+		eina_stringshare_del(file->path);
+	}
+	eina_inarray_free(files);
+end:
+	eina_iterator_free(it);
+}
+
+void snapshot_save(const struct nvim *const nvim)
+{
+	const struct grid *const grid = nvim->grid;
+	const struct gui *const gui = &nvim->gui;
+	char cwd[PATH_MAX];
+	char path[PATH_MAX];
+
+	if ((!_snapshot_enabled(nvim->opts)) || (grid->cols == 0u) || (!gui->font.name))
+		return;
+	if (EINA_UNLIKELY(!_snapshot_path_get(path, sizeof(path), cwd, sizeof(cwd))))
+		return;
+
+	/* [version, cwd, font name, font size, grid] */
+	msgpack_sbuffer sbuf;
+	msgpack_packer pk;
+	msgpack_sbuffer_init(&sbuf);
+	msgpack_packer_init(&pk, &sbuf, msgpack_sbuffer_write);
+	msgpack_pack_array(&pk, 5);
+	msgpack_pack_uint32(&pk, SNAPSHOT_VERSION);
+	msgpack_pack_str_with_body(&pk, cwd, strlen(cwd));
+	msgpack_pack_str_with_body(&pk, gui->font.name, strlen(gui->font.name));
+	msgpack_pack_uint32(&pk, gui->font.size);
+	grid_snapshot_pack(grid, &pk);
+
+	if (cache_write(path, &sbuf))
+		_snapshots_prune();
+	msgpack_sbuffer_destroy(&sbuf);
+}
+
+Eina_Bool snapshot_load(struct nvim *const nvim)
+{
+	const Eina_Rectangle *const geo = &nvim->opts->geometry;
+	struct gui *const gui = &nvim->gui;
+	Eina_Bool ok = EINA_FALSE;
+	char cwd[PATH_MAX];
+	char path[PATH_MAX];
+
+	if (!_snapshot_enabled(nvim->opts))
+		return EINA_FALSE;
+	if (EINA_UNLIKELY(!_snapshot_path_get(path, sizeof(path), cwd, sizeof(cwd))))
+		return EINA_FALSE;
+
+	/* Not having a snapshot (yet) is not an error */
+	Eina_File *const file = eina_file_open(path, EINA_FALSE);
+	if (!file)
+		return EINA_FALSE;
+	const char *const data = eina_file_map_all(file, EINA_FILE_SEQUENTIAL);
+	if (EINA_UNLIKELY(!data)) {
+		ERR("Failed to map the snapshot '%s'", path);
+		goto close;
+	}
+
+	msgpack_unpacked result;
+	msgpack_unpacked_init(&result);
+	size_t offset = 0u;
+	const msgpack_unpack_return ret =
+		msgpack_unpack_next(&result, data, eina_file_size_get(file), &offset);
+	if (EINA_UNLIKELY(ret != MSGPACK_UNPACK_SUCCESS)) {
+		WRN("Failed to unpack the snapshot '%s' (0x%x)", path, ret);
+		goto unmap;
+	}
+
+	/* [version, cwd, font name, font size, grid] */
+	const msgpack_object *const obj = &(result.data);
+	if (EINA_UNLIKELY((obj->type != MSGPACK_OBJECT_ARRAY) || (obj->via.array.size != 5u))) {
+		WRN("The snapshot '%s' is invalid", path);
+		goto unmap;
+	}
+	const msgpack_object *const args = obj->via.array.ptr;
+	if (!_msgpack_uint_is(&args[0], SNAPSHOT_VERSION)) {
+		INF("The snapshot '%s' was saved by another version of eovim", path);
+		goto unmap;
+	}
+	if ((args[1].type != MSGPACK_OBJECT_STR) || (args[1].via.str.size != strlen(cwd)) ||
+	    (memcmp(args[1].via.str.ptr, cwd, args[1].via.str.size) != 0)) {
+		INF("The snapshot '%s' belongs to another directory", path);
+		goto unmap;
+	}
+	if (EINA_UNLIKELY((args[2].type != MSGPACK_OBJECT_STR) ||
+			  (args[3].type != MSGPACK_OBJECT_POSITIVE_INTEGER) ||
+			  (args[3].via.u64 == 0u) || (args[3].via.u64 >= INT_MAX) ||
+			  (args[4].type != MSGPACK_OBJECT_ARRAY) ||
+			  (args[4].via.array.size < 2u))) {
+		WRN("The snapshot '%s' is invalid", path);
+		goto unmap;
+	}
+
+	/* Neovim is attached with the dimensions of the geometry. A snapshot of
+	 * another size would be replaced by a resize before the first frame */
+	const msgpack_object *const dims = args[4].via.array.ptr;
+	if (!_msgpack_uint_is(&dims[0], (uint64_t)geo->w) ||
+	    !_msgpack_uint_is(&dims[1], (uint64_t)geo->h)) {
+		DBG("The snapshot '%s' does not have the requested dimensions", path);
+		goto unmap;
+	}
+	if (EINA_UNLIKELY(!grid_snapshot_load(nvim->grid, &args[4]))) {
+		WRN("Failed to load the grid of the snapshot '%s'", path);
+		goto unmap;
+	}
+
+	Eina_Stringshare *const font_name =
+		eina_stringshare_add_length(args[2].via.str.ptr, args[2].via.str.size);
+	gui_font_set(gui, font_name, (unsigned int)args[3].via.u64);
+	eina_stringshare_del(font_name);
+	gui_default_colors_set(gui, nvim->grid->default_fg, nvim->grid->default_bg);
+	gui_placeholder_show(gui);
+	INF("Showing the snapshot '%s' until neovim is ready", path);
+	ok = EINA_TRUE;
+
+unmap:
+	msgpack_unpacked_destroy(&result);
+	eina_file_map_free(file, (void *)data);
+close:
+	eina_file_close(file);
+	return ok;
+}
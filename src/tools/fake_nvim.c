@@ -0,0 +1,718 @@
+/* This file is part of Eovim, which is under the MIT License ****************/
+
+/*
+ * fake-nvim is a scripted stand-in for neovim. It speaks just enough of the
+ * msgpack-rpc protocol over stdio to let eovim attach to it (see
+ * src/nvim_attach.c), and then emits a programmable redraw workload, always
+ * the same for a given configuration. It allows to perform deterministic
+ * end-to-end measures of eovim, without depending on the version nor the
+ * configuration of neovim:
+ *
+ *   FAKE_NVIM_WORKLOAD=scroll eovim --nvim /path/to/fake-nvim
+ *
+ * It is configured through the following environment variables:
+ *   - FAKE_NVIM_WORKLOAD: scroll (default), edit, highlight or popupmenu;
+ *   - FAKE_NVIM_FRAMES: count of frames to be emitted before exiting (500);
+ *   - FAKE_NVIM_PERIOD: delay between two frames, in milliseconds (16);
+ *   - FAKE_NVIM_ITEMS: count of items of the popupmenu workload (100);
+ *   - FAKE_NVIM_SEED: seed of the pseudo-random generator (1);
+ *   - FAKE_NVIM_NOMODIFIABLE: when not 0, nvim_paste fails as in a buffer
+ *     that is not modifiable (0).
+ *
+ * Pastes are reported on stderr. With FAKE_NVIM_NOMODIFIABLE=1, each paste
+ * (Ctrl+Shift+V) must reach fake-nvim and be refused: eovim must never
+ * report that a paste is already in progress.
+ */
+
+#include <msgpack.h>
+
+#include <errno.h>
+#include <inttypes.h>
+#include <poll.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+enum workload {
+	WORKLOAD_SCROLL, /**< Scroll the buffer by one line per frame */
+	WORKLOAD_EDIT, /**< Rewrite a few random lines per frame */
+	WORKLOAD_HIGHLIGHT, /**< Redefine highlights and redraw the whole grid */
+	WORKLOAD_POPUPMENU, /**< Show a popupmenu of N items, with changing selection */
+};
+
+/* Count of highlight groups defined by fake-nvim. 0 is the default style */
+#define HL_COUNT 8u
+
+struct fake_nvim {
+	msgpack_sbuffer sbuffer;
+	msgpack_packer packer;
+	msgpack_unpacker unpacker;
+
+	enum workload workload;
+	unsigned int frames; /**< Count of frames to be emitted */
+	unsigned int frame; /**< Count of frames already emitted */
+	unsigned int period; /**< Delay between two frames (ms) */
+	unsigned int items; /**< Items count of the popupmenu */
+	uint32_t rand_state;
+	bool nomodifiable; /**< True if nvim_paste must fail */
+
+	unsigned int cols;
+	unsigned int rows;
+	unsigned int first_line; /**< Number of the line at the top of the grid */
+	uint32_t request_id;
+	bool running; /**< True once eovim has answered the vimenter request */
+};
+
+/*============================================================================*
+ *                                 Utilities                                  *
+ *============================================================================*/
+
+static uint32_t _rand(struct fake_nvim *const fn)
+{
+	/* xorshift32: we want the very same sequence on every box */
+	uint32_t x = fn->rand_state;
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	fn->rand_state = x;
+	return x;
+}
+
+static unsigned int _env_uint(const char *const name, const unsigned int fallback)
+{
+	const char *const env = getenv(name);
+	return (env && env[0]) ? (unsigned int)strtoul(env, NULL, 10) : fallback;
+}
+
+static void _pack_str(msgpack_packer *const pk, const char *const str)
+{
+	const size_t len = strlen(str);
+	msgpack_pack_str(pk, len);
+	msgpack_pack_str_body(pk, str, len);
+}
+
+static bool _flush(struct fake_nvim *const fn)
+{
+	const char *data = fn->sbuffer.data;
+	size_t size = fn->sbuffer.size;
+
+	while (size > 0u) {
+		const ssize_t bytes = write(STDOUT_FILENO, data, size);
+		if (bytes < 0) {
+			if (errno == EINTR)
+				continue;
+			fprintf(stderr, "fake-nvim: failed to write to eovim: %s\n",
+				strerror(errno));
+			msgpack_sbuffer_clear(&fn->sbuffer);
+			return false;
+		}
+		data += bytes;
+		size -= (size_t)bytes;
+	}
+	msgpack_sbuffer_clear(&fn->sbuffer);
+	return true;
+}
+
+static bool _obj_streq(const msgpack_object *const obj, const char *const str)
+{
+	const size_t len = strlen(str);
+	if (obj->type == MSGPACK_OBJECT_STR)
+		return (obj->via.str.size == len) && !memcmp(obj->via.str.ptr, str, len);
+	if (obj->type == MSGPACK_OBJECT_BIN)
+		return (obj->via.bin.size == len) && !memcmp(obj->via.bin.ptr, str, len);
+	return false;
+}
+
+/*============================================================================*
+ *                               Redraw Events                                *
+ *============================================================================*/
+
+/* A redraw notification is [2, "redraw", [event...]], where each event is
+ * [name, call...]. The caller packs exactly @p events events. */
+static void _redraw_begin(struct fake_nvim *const fn, const unsigned int events)
+{
+	msgpack_packer *const pk = &fn->packer;
+	msgpack_pack_array(pk, 3);
+	msgpack_pack_int(pk, 2);
+	_pack_str(pk, "redraw");
+	msgpack_pack_array(pk, events);
+}
+
+static void _event_begin(struct fake_nvim *const fn, const char *const name,
+			 const unsigned int calls)
+{
+	msgpack_pack_array(&fn->packer, 1u + calls);
+	_pack_str(&fn->packer, name);
+}
+
+static void _event_flush(struct fake_nvim *const fn)
+{
+	_event_begin(fn, "flush", 1u);
+	msgpack_pack_array(&fn->packer, 0);
+}
+
+static void _event_cursor_goto(struct fake_nvim *const fn, const unsigned int row,
+			       const unsigned int col)
+{
+	msgpack_packer *const pk = &fn->packer;
+	_event_begin(fn, "grid_cursor_goto", 1u);
+	msgpack_pack_array(pk, 3);
+	msgpack_pack_int(pk, 1);
+	msgpack_pack_uint32(pk, row);
+	msgpack_pack_uint32(pk, col);
+}
+
+static void _hl_attr_define_pack(struct fake_nvim *const fn, const unsigned int id,
+				 const uint32_t fg, const uint32_t bg, const bool bold)
+{
+	msgpack_packer *const pk = &fn->packer;
+	msgpack_pack_array(pk, 4);
+	msgpack_pack_uint32(pk, id);
+	msgpack_pack_map(pk, bold ? 3 : 2);
+	_pack_str(pk, "foreground");
+	msgpack_pack_uint32(pk, fg);
+	_pack_str(pk, "background");
+	msgpack_pack_uint32(pk, bg);
+	if (bold) {
+		_pack_str(pk, "bold");
+		msgpack_pack_true(pk);
+	}
+	msgpack_pack_map(pk, 0); /* cterm_attr */
+	msgpack_pack_array(pk, 0); /* info */
+}
+
+static void _event_hl_attr_define(struct fake_nvim *const fn, const bool random_colors)
+{
+	_event_begin(fn, "hl_attr_define", HL_COUNT - 1u);
+	for (unsigned int id = 1u; id < HL_COUNT; id++) {
+		const uint32_t fg = random_colors ? (_rand(fn) & 0xffffff) : (0x404040 * id);
+		const uint32_t bg = random_colors ? (_rand(fn) & 0x3f3f3f) : 0x101010;
+		_hl_attr_define_pack(fn, id, fg & 0xffffff, bg, (id % 3u) == 0u);
+	}
+}
+
+/* Pack a single call of grid_line. The content of a line only depends on its
+ * line number and on the current frame, so the output is reproducible. */
+static void _grid_line_pack(struct fake_nvim *const fn, const unsigned int row,
+			    const unsigned int line)
+{
+	msgpack_packer *const pk = &fn->packer;
+	static const char *const words[] = {
+		"static", "const", "unsigned", "int", "return", "struct", "eovim", "nvim",
+		"flush",  "grid",  "line",     "(",   ")",      "{",      "}",     ";",
+	};
+	char text[1024];
+	const size_t max = (fn->cols < sizeof(text)) ? fn->cols : sizeof(text) - 1u;
+
+	int len = snprintf(text, sizeof(text), "%5u ", line + 1u);
+	uint32_t x = (line + 1u) * 2654435761u + fn->frame;
+	while ((size_t)len < max) {
+		x ^= x << 13;
+		x ^= x >> 17;
+		x ^= x << 5;
+		len += snprintf(text + len, sizeof(text) - (size_t)len, "%s ",
+				words[x % (sizeof(words) / sizeof(words[0]))]);
+	}
+	if ((size_t)len > max)
+		len = (int)max;
+
+	/* Cells are: the line number, then one run of text per word, then blank
+	 * cells up to the end of the line. Each run has its own highlight. */
+	msgpack_pack_array(pk, 4);
+	msgpack_pack_int(pk, 1);
+	msgpack_pack_uint32(pk, row);
+	msgpack_pack_int(pk, 0);
+	msgpack_pack_array(pk, (size_t)len);
+	unsigned int hl = 1u;
+	for (int i = 0; i < len; i++) {
+		const bool run_start = (i == 0) || (text[i - 1] == ' ');
+		if (run_start) {
+			hl = (i < 6) ? 1u : 2u + (unsigned int)(text[i] % (int)(HL_COUNT - 2u));
+			msgpack_pack_array(pk, 2);
+			msgpack_pack_str(pk, 1);
+			msgpack_pack_str_body(pk, &text[i], 1);
+			msgpack_pack_uint32(pk, hl);
+		} else {
+			msgpack_pack_array(pk, 1);
+			msgpack_pack_str(pk, 1);
+			msgpack_pack_str_body(pk, &text[i], 1);
+		}
+	}
+}
+
+static void _event_grid_lines(struct fake_nvim *const fn, const unsigned int from,
+			      const unsigned int to)
+{
+	_event_begin(fn, "grid_line", to - from);
+	for (unsigned int row = from; row < to; row++)
+		_grid_line_pack(fn, row, fn->first_line + row);
+}
+
+/* Draw the whole screen, as neovim does after ui_attach or a resize */
+static bool _screen_draw(struct fake_nvim *const fn)
+{
+	msgpack_packer *const pk = &fn->packer;
+
+	_redraw_begin(fn, 9);
+
+	_event_begin(fn, "default_colors_set", 1u);
+	msgpack_pack_array(pk, 5);
+	msgpack_pack_uint32(pk, 0xd0d0d0);
+	msgpack_pack_uint32(pk, 0x101010);
+	msgpack_pack_uint32(pk, 0xff0000);
+	msgpack_pack_int(pk, 0);
+	msgpack_pack_int(pk, 0);
+
+	_event_hl_attr_define(fn, false);
+
+	_event_begin(fn, "grid_resize", 1u);
+	msgpack_pack_array(pk, 3);
+	msgpack_pack_int(pk, 1);
+	msgpack_pack_uint32(pk, fn->cols);
+	msgpack_pack_uint32(pk, fn->rows);
+
+	_event_begin(fn, "grid_clear", 1u);
+	msgpack_pack_array(pk, 1);
+	msgpack_pack_int(pk, 1);
+
+	_event_begin(fn, "mode_info_set", 1u);
+	msgpack_pack_array(pk, 2);
+	msgpack_pack_true(pk);
+	msgpack_pack_array(pk, 1);
+	msgpack_pack_map(pk, 5);
+	_pack_str(pk, "name");
+	_pack_str(pk, "normal");
+	_pack_str(pk, "short_name");
+	_pack_str(pk, "n");
+	_pack_str(pk, "cursor_shape");
+	_pack_str(pk, "block");
+	_pack_str(pk, "cell_percentage");
+	msgpack_pack_int(pk, 0);
+	_pack_str(pk, "attr_id");
+	msgpack_pack_int(pk, 0);
+
+	_event_begin(fn, "mode_change", 1u);
+	msgpack_pack_array(pk, 2);
+	_pack_str(pk, "normal");
+	msgpack_pack_int(pk, 0);
+
+	_event_grid_lines(fn, 0u, fn->rows);
+	_event_cursor_goto(fn, 0u, 6u);
+	_event_flush(fn);
+
+	return _flush(fn);
+}
+
+/*============================================================================*
+ *                                 Workloads                                  *
+ *============================================================================*/
+
+static void _workload_scroll(struct fake_nvim *const fn)
+{
+	msgpack_packer *const pk = &fn->packer;
+
+	/* Scroll the whole grid by one line, and write the new bottom line */
+	fn->first_line++;
+	_redraw_begin(fn, 4);
+	_event_begin(fn, "grid_scroll", 1u);
+	msgpack_pack_array(pk, 7);
+	msgpack_pack_int(pk, 1);
+	msgpack_pack_int(pk, 0);
+	msgpack_pack_uint32(pk, fn->rows);
+	msgpack_pack_int(pk, 0);
+	msgpack_pack_uint32(pk, fn->cols);
+	msgpack_pack_int(pk, 1);
+	msgpack_pack_int(pk, 0);
+	_event_grid_lines(fn, fn->rows - 1u, fn->rows);
+	_event_cursor_goto(fn, fn->rows - 1u, 6u);
+	_event_flush(fn);
+}
+
+static void _workload_edit(struct fake_nvim *const fn)
+{
+	msgpack_packer *const pk = &fn->packer;
+	const unsigned int edits = 3u;
+
+	_redraw_begin(fn, 3);
+	_event_begin(fn, "grid_line", edits);
+	unsigned int row = 0u;
+	for (unsigned int i = 0u; i < edits; i++) {
+		row = _rand(fn) % fn->rows;
+		_grid_line_pack(fn, row, fn->first_line + row);
+	}
+	_event_begin(fn, "grid_cursor_goto", 1u);
+	msgpack_pack_array(pk, 3);
+	msgpack_pack_int(pk, 1);
+	msgpack_pack_uint32(pk, row);
+	msgpack_pack_uint32(pk, _rand(fn) % fn->cols);
+	_event_flush(fn);
+}
+
+static void _workload_highlight(struct fake_nvim *const fn)
+{
+	_redraw_begin(fn, 3);
+	_event_hl_attr_define(fn, true);
+	_event_grid_lines(fn, 0u, fn->rows);
+	_event_flush(fn);
+}
+
+static void _workload_popupmenu(struct fake_nvim *const fn)
+{
+	msgpack_packer *const pk = &fn->packer;
+	const unsigned int row = fn->rows / 3u;
+	const unsigned int col = fn->cols / 4u;
+	char word[32];
+
+	/* Show the whole popupmenu every 30 frames, change the selection
+	 * otherwise */
+	if ((fn->frame % 30u) == 0u) {
+		_redraw_begin(fn, 2);
+		_event_begin(fn, "popupmenu_show", 1u);
+		msgpack_pack_array(pk, 5);
+		msgpack_pack_array(pk, fn->items);
+		for (unsigned int i = 0u; i < fn->items; i++) {
+			snprintf(word, sizeof(word), "completion_item_%u", i + fn->frame);
+			msgpack_pack_array(pk, 4);
+			_pack_str(pk, word);
+			_pack_str(pk, (i % 2u) ? "f" : "v");
+			_pack_str(pk, "[fake]");
+			_pack_str(pk, "");
+		}
+		msgpack_pack_int(pk, -1);
+		msgpack_pack_uint32(pk, row);
+		msgpack_pack_uint32(pk, col);
+		msgpack_pack_int(pk, 1);
+	} else {
+		_redraw_begin(fn, 2);
+		_event_begin(fn, "popupmenu_select", 1u);
+		msgpack_pack_array(pk, 1);
+		msgpack_pack_uint32(pk, fn->items ? (fn->frame % fn->items) : 0u);
+	}
+	_event_flush(fn);
+}
+
+static bool _frame_emit(struct fake_nvim *const fn)
+{
+	switch (fn->workload) {
+	case WORKLOAD_EDIT:
+		_workload_edit(fn);
+		break;
+	case WORKLOAD_HIGHLIGHT:
+		_workload_highlight(fn);
+		break;
+	case WORKLOAD_POPUPMENU:
+		_workload_popupmenu(fn);
+		break;
+	case WORKLOAD_SCROLL: /* Fall through */
+	default:
+		_workload_scroll(fn);
+		break;
+	}
+	fn->frame++;
+	return _flush(fn);
+}
+
+/*============================================================================*
+ *                               RPC Handling                                 *
+ *============================================================================*/
+
+static void _response_begin(struct fake_nvim *const fn, const uint64_t msgid)
+{
+	msgpack_packer *const pk = &fn->packer;
+	msgpack_pack_array(pk, 4);
+	msgpack_pack_int(pk, 1);
+	msgpack_pack_uint64(pk, msgid);
+	msgpack_pack_nil(pk); /* Error */
+	/* The caller packs the result */
+}
+
+static void _response_error(struct fake_nvim *const fn, const uint64_t msgid,
+			    const char *const error)
+{
+	msgpack_packer *const pk = &fn->packer;
+	msgpack_pack_array(pk, 4);
+	msgpack_pack_int(pk, 1);
+	msgpack_pack_uint64(pk, msgid);
+	msgpack_pack_array(pk, 2);
+	msgpack_pack_int(pk, 0);
+	_pack_str(pk, error);
+	msgpack_pack_nil(pk);
+}
+
+static void _api_info_pack(struct fake_nvim *const fn)
+{
+	msgpack_packer *const pk = &fn->packer;
+	static const char *const ui_options[] = {
+		"rgb", "ext_cmdline", "ext_popupmenu", "ext_tabline", "ext_linegrid", "ext_hlstate",
+	};
+
+	msgpack_pack_array(pk, 2);
+	msgpack_pack_int(pk, 1); /* Channel */
+	msgpack_pack_map(pk, 2);
+	_pack_str(pk, "version");
+	msgpack_pack_map(pk, 3);
+	_pack_str(pk, "major");
+	msgpack_pack_int(pk, 0);
+	_pack_str(pk, "minor");
+	msgpack_pack_int(pk, 5);
+	_pack_str(pk, "patch");
+	msgpack_pack_int(pk, 0);
+	_pack_str(pk, "ui_options");
+	msgpack_pack_array(pk, sizeof(ui_options) / sizeof(ui_options[0]));
+	for (size_t i = 0u; i < sizeof(ui_options) / sizeof(ui_options[0]); i++)
+		_pack_str(pk, ui_options[i]);
+}
+
+static void _config_pack(struct fake_nvim *const fn, const uint64_t msgid)
+{
+	msgpack_packer *const pk = &fn->packer;
+
+	/* Same values than the runtime.vim, but with animations disabled so
+	 * measures are not polluted by them. */
+	static const struct {
+		const char *const name;
+		const int value;
+	} integers[] = {
+		{ "eovim_theme_bell_enabled", 0 },
+		{ "eovim_theme_react_to_key_presses", 0 },
+		{ "eovim_theme_react_to_caps_lock", 1 },
+		{ "eovim_cursor_cuts_ligatures", 1 },
+		{ "eovim_cursor_animated", 0 },
+		{ "eovim_perf_hud", 0 },
+		{ "eovim_key_repeat_throttle", 0 },
+		{ "eovim_predictive_echo", 0 },
+		{ "eovim_ext_tabline", 1 },
+		{ "eovim_ext_popupmenu", 1 },
+		{ "eovim_ext_cmdline", 1 },
+	};
+	const size_t count = sizeof(integers) / sizeof(integers[0]);
+
+	/* eovim only evaluates the dictionary of its g:eovim_* variables */
+	_response_begin(fn, msgid);
+	msgpack_pack_map(pk, count + 4u);
+	for (size_t i = 0u; i < count; i++) {
+		_pack_str(pk, integers[i].name);
+		msgpack_pack_int(pk, integers[i].value);
+	}
+	_pack_str(pk, "eovim_cursor_animation_duration");
+	msgpack_pack_double(pk, 0.05);
+	_pack_str(pk, "eovim_cursor_animation_style");
+	_pack_str(pk, "linear");
+	_pack_str(pk, "eovim_theme_completion_styles");
+	msgpack_pack_map(pk, 0);
+	_pack_str(pk, "eovim_theme_cmdline_styles");
+	msgpack_pack_map(pk, 0);
+}
+
+static bool _ui_size_get(struct fake_nvim *const fn, const msgpack_object_array *const args)
+{
+	if ((args->size < 2u) || (args->ptr[0].type != MSGPACK_OBJECT_POSITIVE_INTEGER) ||
+	    (args->ptr[1].type != MSGPACK_OBJECT_POSITIVE_INTEGER) ||
+	    (args->ptr[0].via.u64 == 0u) || (args->ptr[1].via.u64 == 0u))
+		return false;
+	fn->cols = (unsigned int)args->ptr[0].via.u64;
+	fn->rows = (unsigned int)args->ptr[1].via.u64;
+	return true;
+}
+
+static bool _request_handle(struct fake_nvim *const fn, const msgpack_object_array *const msg)
+{
+	/* [0, msgid, method, args] */
+	if ((msg->size != 4u) || (msg->ptr[1].type != MSGPACK_OBJECT_POSITIVE_INTEGER) ||
+	    (msg->ptr[3].type != MSGPACK_OBJECT_ARRAY)) {
+		fprintf(stderr, "fake-nvim: malformed request\n");
+		return true;
+	}
+	const uint64_t msgid = msg->ptr[1].via.u64;
+	const msgpack_object *const method = &msg->ptr[2];
+	const msgpack_object_array *const args = &msg->ptr[3].via.array;
+
+	if (_obj_streq(method, "nvim_get_api_info")) {
+		_response_begin(fn, msgid);
+		_api_info_pack(fn);
+	} else if (_obj_streq(method, "nvim_eval")) {
+		_config_pack(fn, msgid);
+	} else if (_obj_streq(method, "nvim_ui_attach")) {
+		if (!_ui_size_get(fn, args)) {
+			_response_error(fn, msgid, "Invalid dimensions");
+			return _flush(fn);
+		}
+		_response_begin(fn, msgid);
+		msgpack_pack_nil(&fn->packer);
+		if (!_flush(fn) || !_screen_draw(fn))
+			return false;
+
+		/* Startup is done: trigger the VimEnter autocmd that eovim's
+		 * runtime registered */
+		msgpack_packer *const pk = &fn->packer;
+		msgpack_pack_array(pk, 4);
+		msgpack_pack_int(pk, 0);
+		msgpack_pack_uint32(pk, fn->request_id++);
+		_pack_str(pk, "vimenter");
+		msgpack_pack_array(pk, 0);
+	} else if (_obj_streq(method, "nvim_call_atomic")) {
+		/* All the calls are accepted and do nothing: [[nil...], nil] */
+		uint32_t calls = 0u;
+		if ((args->size == 1u) && (args->ptr[0].type == MSGPACK_OBJECT_ARRAY))
+			calls = args->ptr[0].via.array.size;
+		_response_begin(fn, msgid);
+		msgpack_pack_array(&fn->packer, 2);
+		msgpack_pack_array(&fn->packer, calls);
+		for (uint32_t i = 0u; i < calls; i++)
+			msgpack_pack_nil(&fn->packer);
+		msgpack_pack_nil(&fn->packer);
+	} else if (_obj_streq(method, "nvim_paste")) {
+		/* [data, crlf, phase] */
+		const bool valid = (args->size == 3u) && (args->ptr[0].type == MSGPACK_OBJECT_STR);
+		const uint32_t size = (valid) ? args->ptr[0].via.str.size : 0u;
+		if (fn->nomodifiable) {
+			fprintf(stderr, "fake-nvim: refused a paste of %" PRIu32 " bytes\n", size);
+			_response_error(fn, msgid,
+					"Vim:E21: Cannot make changes, 'modifiable' is off");
+		} else {
+			fprintf(stderr, "fake-nvim: pasted %" PRIu32 " bytes\n", size);
+			_response_begin(fn, msgid);
+			msgpack_pack_true(&fn->packer);
+		}
+	} else if (_obj_streq(method, "nvim_ui_try_resize")) {
+		_response_begin(fn, msgid);
+		msgpack_pack_nil(&fn->packer);
+		if (_ui_size_get(fn, args))
+			return _flush(fn) && _screen_draw(fn);
+	} else {
+		/* nvim_command, nvim_input, nvim_ui_set_option, ... are accepted
+		 * and do nothing. */
+		_response_begin(fn, msgid);
+		msgpack_pack_nil(&fn->packer);
+	}
+	return _flush(fn);
+}
+
+static bool _message_handle(struct fake_nvim *const fn, const msgpack_object *const obj)
+{
+	if ((obj->type != MSGPACK_OBJECT_ARRAY) || (obj->via.array.size < 3u) ||
+	    (obj->via.array.ptr[0].type != MSGPACK_OBJECT_POSITIVE_INTEGER)) {
+		fprintf(stderr, "fake-nvim: unexpected message\n");
+		return true;
+	}
+	const msgpack_object_array *const msg = &obj->via.array;
+	switch (msg->ptr[0].via.u64) {
+	case 0: /* Request */
+		return _request_handle(fn, msg);
+	case 1: /* Response: the only request we send is vimenter */
+		fn->running = true;
+		return true;
+	default: /* Notifications are ignored */
+		return true;
+	}
+}
+
+static bool _input_read(struct fake_nvim *const fn)
+{
+	msgpack_unpacker *const unpacker = &fn->unpacker;
+	if (msgpack_unpacker_buffer_capacity(unpacker) < 4096u) {
+		if (!msgpack_unpacker_reserve_buffer(unpacker, 4096u)) {
+			fprintf(stderr, "fake-nvim: out of memory\n");
+			return false;
+		}
+	}
+
+	const ssize_t bytes = read(STDIN_FILENO, msgpack_unpacker_buffer(unpacker),
+				   msgpack_unpacker_buffer_capacity(unpacker));
+	if (bytes <= 0)
+		return (bytes < 0) && (errno == EINTR); /* EOF: eovim is gone */
+	msgpack_unpacker_buffer_consumed(unpacker, (size_t)bytes);
+
+	bool ok = true;
+	msgpack_unpacked result;
+	msgpack_unpacked_init(&result);
+	for (;;) {
+		const msgpack_unpack_return ret = msgpack_unpacker_next(unpacker, &result);
+		if (ret == MSGPACK_UNPACK_CONTINUE)
+			break;
+		if (ret != MSGPACK_UNPACK_SUCCESS) {
+			fprintf(stderr, "fake-nvim: failed to unpack data (%i)\n", ret);
+			ok = false;
+			break;
+		}
+		if (!_message_handle(fn, &result.data)) {
+			ok = false;
+			break;
+		}
+	}
+	msgpack_unpacked_destroy(&result);
+	return ok;
+}
+
+int main(int argc, char **argv)
+{
+	struct fake_nvim fn = {
+		.frames = _env_uint("FAKE_NVIM_FRAMES", 500u),
+		.period = _env_uint("FAKE_NVIM_PERIOD", 16u),
+		.items = _env_uint("FAKE_NVIM_ITEMS", 100u),
+		.rand_state = _env_uint("FAKE_NVIM_SEED", 1u),
+		.nomodifiable = _env_uint("FAKE_NVIM_NOMODIFIABLE", 0u) != 0u,
+		.cols = 120u,
+		.rows = 40u,
+	};
+
+	/* eovim runs us with --embed, and forwards its own arguments. Ignore
+	 * them all. */
+	(void)argc;
+	(void)argv;
+
+	if (fn.rand_state == 0u)
+		fn.rand_state = 1u; /* xorshift must not be seeded with zero */
+
+	const char *const workload = getenv("FAKE_NVIM_WORKLOAD");
+	if (!workload || !strcmp(workload, "scroll"))
+		fn.workload = WORKLOAD_SCROLL;
+	else if (!strcmp(workload, "edit"))
+		fn.workload = WORKLOAD_EDIT;
+	else if (!strcmp(workload, "highlight"))
+		fn.workload = WORKLOAD_HIGHLIGHT;
+	else if (!strcmp(workload, "popupmenu"))
+		fn.workload = WORKLOAD_POPUPMENU;
+	else {
+		fprintf(stderr, "fake-nvim: unknown workload '%s'\n", workload);
+		return EXIT_FAILURE;
+	}
+
+	msgpack_sbuffer_init(&fn.sbuffer);
+	msgpack_packer_init(&fn.packer, &fn.sbuffer, msgpack_sbuffer_write);
+	if (!msgpack_unpacker_init(&fn.unpacker, 4096u)) {
+		fprintf(stderr, "fake-nvim: failed to initialize the unpacker\n");
+		msgpack_sbuffer_destroy(&fn.sbuffer);
+		return EXIT_FAILURE;
+	}
+
+	int return_code = EXIT_SUCCESS;
+	struct pollfd pfd = { .fd = STDIN_FILENO, .events = POLLIN };
+	while (fn.frame < fn.frames) {
+		/* Until eovim is attached, only wait for its requests. Then,
+		 * emit a frame each time the period elapses without input */
+		const int timeout = fn.running ? (int)fn.period : -1;
+		const int ret = poll(&pfd, 1, timeout);
+		if (ret < 0) {
+			if (errno == EINTR)
+				continue;
+			fprintf(stderr, "fake-nvim: poll() failed: %s\n", strerror(errno));
+			return_code = EXIT_FAILURE;
+			break;
+		}
+		if (ret > 0) {
+			if (!_input_read(&fn))
+				break;
+		} else if (!_frame_emit(&fn)) {
+			return_code = EXIT_FAILURE;
+			break;
+		}
+	}
+
+	msgpack_unpacker_destroy(&fn.unpacker);
+	msgpack_sbuffer_destroy(&fn.sbuffer);
+	return return_code;
+}
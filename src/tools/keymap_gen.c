@@ -0,0 +1,158 @@
+/* This file is part of Eovim, which is under the MIT License ****************/
+
+/*
+ * keymap-gen generates the key translation tables of eovim (see
+ * src/keymap.c) from the list of special keys of src/keymap_keys.h. It is run
+ * at build time:
+ *
+ *   keymap-gen /path/to/eovim/keymap_table.h
+ *
+ * The generated table is indexed by a perfect hash of the keys: keymap-gen
+ * searches for the smallest table and the seed of keymap_hash() that map each
+ * key to its own slot. Each entry holds the strings to be sent to neovim for
+ * every combination of modifiers, so nothing is formatted at runtime.
+ *
+ * keymap-gen fails if a key is listed twice.
+ */
+
+#include "eovim/keymap.h"
+#include "../keymap_hash.h"
+
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+struct key {
+	const char *key; /**< Name of the key for Ecore */
+	const char *name; /**< Name of the key for neovim */
+	bool caps_lock;
+};
+
+#define KM(Key, Std) {.key = Key, .name = Std},
+#define KM_IDENT(Key) KM(Key, Key)
+#define KM_CAPS_LOCK(Key) {.key = Key, .caps_lock = true},
+
+static const struct key _keys[] = {
+#include "../keymap_keys.h"
+};
+
+#define KEYS_COUNT (sizeof(_keys) / sizeof(_keys[0]))
+
+/* The table never exceeds 2^MAX_BITS slots, and as many seeds are tried for
+ * each size of table */
+#define MAX_BITS 10u
+#define MAX_SEEDS (1u << 20)
+
+static bool _keys_check(void)
+{
+	bool ok = true;
+	for (size_t i = 0u; i < KEYS_COUNT; i++) {
+		for (size_t j = i + 1u; j < KEYS_COUNT; j++) {
+			if (!strcmp(_keys[i].key, _keys[j].key)) {
+				fprintf(stderr, "keymap-gen: key '%s' is listed twice\n",
+					_keys[i].key);
+				ok = false;
+			}
+		}
+	}
+	return ok;
+}
+
+static bool _seed_try(const uint32_t seed, const uint32_t mask, int *const slots)
+{
+	for (uint32_t i = 0u; i <= mask; i++)
+		slots[i] = -1;
+
+	for (size_t i = 0u; i < KEYS_COUNT; i++) {
+		const uint32_t slot = keymap_hash(_keys[i].key, seed) & mask;
+		if (slots[slot] >= 0)
+			return false;
+		slots[slot] = (int)i;
+	}
+	return true;
+}
+
+static void _input_write(FILE *const file, const char *const name, const unsigned int mods)
+{
+	/* Modifiers are always written in this order, e.g. <C-S-D-A-Up> */
+	char str[64];
+	const int size = snprintf(str, sizeof(str), "<%s%s%s%s%s>",
+				  (mods & KEYMAP_MOD_CTRL) ? "C-" : "",
+				  (mods & KEYMAP_MOD_SHIFT) ? "S-" : "",
+				  (mods & KEYMAP_MOD_SUPER) ? "D-" : "",
+				  (mods & KEYMAP_MOD_ALT) ? "A-" : "", name);
+	fprintf(file, "\t\t\t\t{.size = %d, .str = \"%s\"},\n", size, str);
+}
+
+static void _table_write(FILE *const file, const uint32_t seed, const uint32_t mask,
+			 const int *const slots)
+{
+	fprintf(file, "/* Generated by keymap-gen from src/keymap_keys.h. Do not edit */\n\n");
+	fprintf(file, "#define KEYMAP_SEED 0x%08" PRIx32 "u\n", seed);
+	fprintf(file, "#define KEYMAP_MASK 0x%" PRIx32 "u\n\n", mask);
+	fprintf(file, "static const struct kv_keymap _map[KEYMAP_MASK + 1u] = {\n");
+
+	for (uint32_t i = 0u; i <= mask; i++) {
+		if (slots[i] < 0)
+			continue;
+		const struct key *const key = &(_keys[slots[i]]);
+
+		fprintf(file, "\t[%" PRIu32 "] = {\n", i);
+		fprintf(file, "\t\t.key = \"%s\",\n", key->key);
+		fprintf(file, "\t\t.keymap = {\n");
+		if (key->caps_lock)
+			fprintf(file, "\t\t\t.caps_lock = EINA_TRUE,\n");
+		else {
+			fprintf(file, "\t\t\t.name = \"%s\",\n", key->name);
+			fprintf(file, "\t\t\t.inputs = {\n");
+			for (unsigned int mods = 0u; mods < KEYMAP_MODS_COUNT; mods++)
+				_input_write(file, key->name, mods);
+			fprintf(file, "\t\t\t},\n");
+		}
+		fprintf(file, "\t\t},\n");
+		fprintf(file, "\t},\n");
+	}
+	fprintf(file, "};\n");
+}
+
+int main(int argc, char **argv)
+{
+	if (argc != 2) {
+		fprintf(stderr, "Usage: %s <output>\n", argv[0]);
+		return EXIT_FAILURE;
+	}
+	if (!_keys_check())
+		return EXIT_FAILURE;
+
+	/* Start with the smallest power of two that can hold all the keys */
+	unsigned int bits = 0u;
+	while ((1u << bits) < KEYS_COUNT)
+		bits++;
+
+	static int slots[1u << MAX_BITS];
+	for (; bits <= MAX_BITS; bits++) {
+		const uint32_t mask = (1u << bits) - 1u;
+		for (uint32_t seed = 0u; seed < MAX_SEEDS; seed++) {
+			if (!_seed_try(seed, mask, slots))
+				continue;
+
+			FILE *const file = fopen(argv[1], "w");
+			if (!file) {
+				fprintf(stderr, "keymap-gen: failed to open '%s'\n", argv[1]);
+				return EXIT_FAILURE;
+			}
+			_table_write(file, seed, mask, slots);
+			if (fclose(file) != 0) {
+				fprintf(stderr, "keymap-gen: failed to write '%s'\n", argv[1]);
+				return EXIT_FAILURE;
+			}
+			return EXIT_SUCCESS;
+		}
+	}
+
+	fprintf(stderr, "keymap-gen: no perfect hash found for %zu keys\n", KEYS_COUNT);
+	return EXIT_FAILURE;
+}